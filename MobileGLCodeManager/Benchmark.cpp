@@ -0,0 +1,354 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <unordered_map>
+
+#include "CMD_implementFunction.h"
+#include "CMD_dispatch.h"
+#include "DefinitionIndex.h"
+#include "FileUtils.h"
+
+// Benchmarks the impl building blocks on synthetic MobileGL workspaces.
+//
+//   MobileGLCodeManagerBench [--sizes 100,1000,10000] [--components 16] [--iterations 20]
+//                            [--workdir <dir>] [--out <file>] [--baseline <file>] [--tolerance 0.25]
+//                            [--min-delta-us 100]
+//
+// Results are printed as one JSON object per line. With --baseline, any benchmark
+// whose median is slower than baseline * (1 + tolerance), and by at least
+// min-delta-us, fails the run.
+
+namespace fs = std::filesystem;
+
+struct BenchOptions {
+    std::vector<size_t> sizes = { 100, 1000, 10000 };
+    size_t components = 16;
+    size_t iterations = 20;
+    fs::path workdir = fs::temp_directory_path() / "MobileGLCodeManagerBench";
+    std::string outPath;
+    std::string baselinePath;
+    double tolerance = 0.25;
+    double minDeltaUs = 100; // ignore slowdowns smaller than this; sub-100us timings are mostly noise
+};
+
+struct BenchResult {
+    std::string name;
+    size_t entries = 0;
+    double medianUs = 0;
+    double meanUs = 0;
+    double minUs = 0;
+    size_t iterations = 0;
+};
+
+static constexpr size_t DISPATCH_LOOKUPS = 1000;
+
+static const char* PARAM_TYPES[] = { "GLenum target", "GLuint index", "GLint level", "GLsizei count", "const void* data", "GLfloat value" };
+static const char* RETURN_TYPES[] = { "void", "GLboolean", "GLuint", "const GLubyte*" };
+
+static std::string BenchFunctionName(size_t i) {
+    return "glBenchFunction" + std::to_string(i);
+}
+
+static std::string BenchComponentName(size_t i) {
+    return "BenchComponent" + std::to_string(i);
+}
+
+// Lays out a workspace shaped like the MobileGL tree: a Definitions.cpp with 'entries'
+// stubbed DECLARE_GL_FUNCTION_* entries, a CMakeLists.txt with the GLImpl insertion
+// point, and 'components' components that already own a few functions.
+static void GenerateWorkspace(const fs::path& root, size_t entries, size_t components) {
+    fs::remove_all(root);
+
+    std::string definitions = "#include \"Definitions.h\"\n\n";
+    for (size_t i = 0; i < entries; ++i) {
+        std::string name = BenchFunctionName(i);
+        std::string returnType = RETURN_TYPES[i % std::size(RETURN_TYPES)];
+        std::string params;
+        std::string args;
+        for (size_t p = 0; p < i % 4; ++p) {
+            std::string param = PARAM_TYPES[(i + p) % std::size(PARAM_TYPES)];
+            std::string paramName = param.substr(param.rfind(' ') + 1) + std::to_string(p);
+            params += ", " + param + std::to_string(p);
+            args += ", " + paramName;
+        }
+        std::string end = returnType == "void" ? "END_NO_RETURN" : "END";
+        definitions += "DECLARE_GL_FUNCTION_STUB_HEAD(" + returnType + ", " + name + params + ") "
+            "DECLARE_GL_FUNCTION_STUB_" + end + "(" + name + args + ")\n";
+    }
+    WriteToFile((root / DEFINITIONS_FILE_PATH).string(), definitions);
+
+    std::string cmake =
+        "cmake_minimum_required(VERSION 3.20)\n"
+        "project(MobileGL)\n"
+        "add_library(MobileGL SHARED\n"
+        "    MobileGL/MG_Impl/GLImpl/Exporting/Definitions.cpp\n"
+        "    # @INSERTION_POINT:SOURCE_FILE_GLIMPL@ #\n";
+    for (size_t c = 0; c < components; ++c) {
+        cmake += "    MobileGL/MG_Impl/GLImpl/" + BenchComponentName(c) + "/GL_" + BenchComponentName(c) + ".cpp\n";
+    }
+    cmake += ")\n";
+    WriteToFile((root / CMAKELISTS_FILE_PATH).string(), cmake);
+
+    for (size_t c = 0; c < components; ++c) {
+        std::string component = BenchComponentName(c);
+        std::string prefix = (root / GL_IMPL_DIRECTORY_PATH / component / ("GL_" + component)).string();
+        std::string header =
+            "#pragma once\n#include <Includes.h>\n\nnamespace MobileGL {\n    namespace MG_Impl::GLImpl {\n"
+            "        /* @INSERTION_POINT:FUNCTION_DECLARATION@ */\n";
+        std::string source = "#include \"GL_" + component + ".h\"\n\nnamespace MobileGL {\n    namespace MG_Impl::GLImpl {\n"
+            "        /* @INSERTION_POINT:FUNCTION_IMPLEMENTATION@ */\n";
+        for (size_t f = 0; f < 8; ++f) {
+            std::string name = "glExisting" + std::to_string(c) + "_" + std::to_string(f);
+            header += "        void " + name + "(GLenum target);\n";
+            source += "        void " + name + "(GLenum target) {\n            // TODO: implement\n        }\n        \n";
+        }
+        header += "    } // namespace MG_Impl::GLImpl\n} // namespace MobileGL";
+        source += "    } // namespace MG_Impl::GLImpl\n} // namespace MobileGL";
+        WriteToFile(prefix + ".h", header);
+        WriteToFile(prefix + ".cpp", source);
+    }
+}
+
+static BenchResult Measure(const std::string& name, size_t entries, size_t iterations,
+    const std::function<void(size_t)>& body) {
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body(i);
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.entries = entries;
+    result.iterations = iterations;
+    std::sort(samples.begin(), samples.end());
+    result.minUs = samples.front();
+    result.medianUs = samples[samples.size() / 2];
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+    result.meanUs = sum / samples.size();
+    return result;
+}
+
+static std::string ToJson(const BenchResult& result) {
+    std::ostringstream json;
+    json << "{\"name\": \"" << result.name << "\", \"entries\": " << result.entries
+        << ", \"median_us\": " << result.medianUs << ", \"mean_us\": " << result.meanUs
+        << ", \"min_us\": " << result.minUs << ", \"iterations\": " << result.iterations << "}";
+    return json.str();
+}
+
+static bool ReadJsonNumber(const std::string& line, const std::string& key, double& value) {
+    size_t pos = line.find("\"" + key + "\":");
+    if (pos == std::string::npos) return false;
+    value = std::strtod(line.c_str() + pos + key.size() + 3, nullptr);
+    return true;
+}
+
+static bool ReadJsonString(const std::string& line, const std::string& key, std::string& value) {
+    size_t pos = line.find("\"" + key + "\": \"");
+    if (pos == std::string::npos) return false;
+    size_t begin = pos + key.size() + 5;
+    size_t end = line.find('"', begin);
+    if (end == std::string::npos) return false;
+    value = line.substr(begin, end - begin);
+    return true;
+}
+
+// Reads results written by a previous run (one JSON object per line).
+static std::vector<BenchResult> ReadBaseline(const std::string& filename) {
+    std::vector<BenchResult> results;
+    std::istringstream stream(GetFileContent(filename));
+    std::string line;
+    while (std::getline(stream, line)) {
+        BenchResult result;
+        double entries = 0;
+        if (!ReadJsonString(line, "name", result.name) ||
+            !ReadJsonNumber(line, "entries", entries) ||
+            !ReadJsonNumber(line, "median_us", result.medianUs)) {
+            continue;
+        }
+        result.entries = static_cast<size_t>(entries);
+        results.push_back(result);
+    }
+    return results;
+}
+
+static std::vector<BenchResult> RunBenchmarks(const BenchOptions& options) {
+    std::vector<BenchResult> results;
+    const fs::path originalDir = fs::current_path();
+
+    for (size_t entries : options.sizes) {
+        // Every iteration implements fresh functions, so make sure there are enough.
+        size_t functionCount = std::max(entries, 1 + options.iterations * (2 + options.components));
+        fs::path root = options.workdir / ("entries_" + std::to_string(entries));
+        GenerateWorkspace(root, functionCount, options.components);
+        fs::current_path(root);
+
+        const std::string definitions = DEFINITIONS_FILE_PATH;
+        size_t nextFunction = 0;
+        auto takeFunction = [&] { return BenchFunctionName(nextFunction++); };
+
+        results.push_back(Measure("DefinitionIndex::Build", entries, options.iterations, [&](size_t) {
+            DefinitionIndex index;
+            index.Build(GetFileContent(definitions));
+        }));
+
+        {
+            // GetProcAddress-style lookups by GL function name: the generated perfect
+            // hash against an unordered_map and a linear scan. One query in ten misses.
+            DefinitionIndex index;
+            index.Build(GetFileContent(definitions));
+            std::vector<std::string_view> names;
+            for (const auto& entry : index.Entries()) names.push_back(entry.name);
+            std::vector<std::string> queries;
+            for (size_t q = 0; q < DISPATCH_LOOKUPS; ++q) {
+                queries.push_back(q % 10 == 9 ? "glMissing" + std::to_string(q) : std::string(names[(q * 7919) % names.size()]));
+            }
+
+            PerfectHash hash;
+            hash.Build(names);
+            std::vector<std::string_view> namesBySlot(names.size());
+            for (size_t i = 0; i < names.size(); ++i) namesBySlot[hash.SlotOf(i)] = names[i];
+            std::unordered_map<std::string_view, size_t> nameMap;
+            for (size_t i = 0; i < names.size(); ++i) nameMap.emplace(names[i], i);
+
+            size_t found = 0;
+            results.push_back(Measure("DispatchLookup(perfect hash)", entries, options.iterations, [&](size_t) {
+                for (const auto& query : queries) found += namesBySlot[hash.Slot(query)] == query;
+            }));
+            results.push_back(Measure("DispatchLookup(unordered_map)", entries, options.iterations, [&](size_t) {
+                for (const auto& query : queries) found += nameMap.find(query) != nameMap.end();
+            }));
+            results.push_back(Measure("DispatchLookup(linear)", entries, options.iterations, [&](size_t) {
+                for (const auto& query : queries) found += std::find(names.begin(), names.end(), query) != names.end();
+            }));
+            if (found != 3 * options.iterations * (DISPATCH_LOOKUPS - DISPATCH_LOOKUPS / 10)) {
+                throw std::runtime_error("Dispatch lookups disagree");
+            }
+
+            results.push_back(Measure("GenerateDispatchHeader", entries, options.iterations, [&](size_t) {
+                GenerateDispatchHeader(index);
+            }));
+        }
+
+        std::string toggled = takeFunction();
+        results.push_back(Measure("SetFunctionStub", entries, options.iterations, [&](size_t i) {
+            SetFunctionStub(definitions, toggled, i % 2 != 0);
+        }));
+
+        results.push_back(Measure("MakeSureSourceInCMakeListsFile", entries, options.iterations, [&](size_t i) {
+            MakeSureSourceInCMakeListsFile("BenchCMakeComponent" + std::to_string(i));
+        }));
+
+        results.push_back(Measure("WriteSourceAndHeaderFiles", entries, options.iterations, [&](size_t i) {
+            WriteSourceAndHeaderFiles(takeFunction(), BenchComponentName(i % options.components));
+        }));
+
+        results.push_back(Measure("implementFunction", entries, options.iterations, [&](size_t i) {
+            implementFunction(takeFunction(), BenchComponentName(i % options.components));
+        }));
+
+        std::vector<std::vector<ImplRequest>> batches(options.iterations);
+        for (auto& batch : batches) {
+            for (size_t c = 0; c < options.components; ++c) {
+                batch.push_back({ takeFunction(), BenchComponentName(c) });
+            }
+        }
+        results.push_back(Measure("implementFunctions(batch)", entries, options.iterations, [&](size_t i) {
+            implementFunctions(batches[i]);
+        }));
+
+        fs::current_path(originalDir);
+        fs::remove_all(root);
+    }
+    return results;
+}
+
+static std::vector<size_t> ParseSizes(const std::string& text) {
+    std::vector<size_t> sizes;
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        sizes.push_back(std::stoul(item));
+    }
+    return sizes;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--sizes") options.sizes = ParseSizes(value());
+            else if (arg == "--components") options.components = std::max<size_t>(1, std::stoul(value()));
+            else if (arg == "--iterations") options.iterations = std::max<size_t>(1, std::stoul(value()));
+            else if (arg == "--workdir") options.workdir = fs::absolute(value());
+            else if (arg == "--out") options.outPath = value();
+            else if (arg == "--baseline") options.baselinePath = value();
+            else if (arg == "--tolerance") options.tolerance = std::stod(value());
+            else if (arg == "--min-delta-us") options.minDeltaUs = std::stod(value());
+            else throw std::runtime_error("Unknown option: " + arg);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+
+    std::vector<BenchResult> results;
+    {
+        // The commands report every edit on stdout; keep that out of the results.
+        std::ostringstream discarded;
+        std::streambuf* coutBuffer = std::cout.rdbuf(discarded.rdbuf());
+        try {
+            results = RunBenchmarks(options);
+        }
+        catch (const std::exception& e) {
+            std::cout.rdbuf(coutBuffer);
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout.rdbuf(coutBuffer);
+    }
+
+    std::string output;
+    for (const auto& result : results) {
+        output += ToJson(result) + "\n";
+    }
+    std::cout << output;
+    if (!options.outPath.empty()) {
+        WriteToFile(options.outPath, output);
+    }
+
+    if (options.baselinePath.empty()) {
+        return 0;
+    }
+
+    int status = 0;
+    for (const auto& baseline : ReadBaseline(options.baselinePath)) {
+        for (const auto& result : results) {
+            if (result.name != baseline.name || result.entries != baseline.entries) continue;
+            double limit = std::max(baseline.medianUs * (1.0 + options.tolerance), baseline.medianUs + options.minDeltaUs);
+            if (result.medianUs > limit) {
+                std::cerr << "Regression: " << result.name << " @ " << result.entries << " entries: "
+                    << result.medianUs << " us > " << limit << " us (baseline " << baseline.medianUs << " us)" << std::endl;
+                status = 1;
+            }
+        }
+    }
+    return status;
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+#include "CMD_implementFunction.h"
+#include "Commands.h"
+#include "ComponentScanner.h"
+#include "DefinitionIndex.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+#include "Progress.h"
+
+struct ComponentCoverage {
+    std::string name;
+    size_t declared = 0;
+    size_t implemented = 0;
+    std::vector<std::string> stillStubbed; // declared here, but still a stub in Definitions.cpp
+};
+
+struct CoverageReport {
+    size_t totalFunctions = 0;
+    size_t implementedFunctions = 0;
+    size_t stubFunctions = 0;
+    std::vector<ComponentCoverage> components;
+    std::vector<std::string> missingDeclaration; // implemented in Definitions.cpp, declared by no component
+};
+
+static CoverageReport BuildCoverageReport() {
+    ScopedTimer timer("BuildCoverageReport");
+
+    const DefinitionIndex& index = GetDefinitionIndex(DEFINITIONS_FILE_PATH);
+    CoverageReport report;
+    for (const auto& entry : index.Entries()) {
+        ++report.totalFunctions;
+        if (entry.isStub) ++report.stubFunctions;
+        else ++report.implementedFunctions;
+    }
+
+    std::unordered_map<std::string, size_t> declaringComponents;
+    std::vector<std::string> components = ListComponents();
+    AddProgressTotal(components.size());
+    for (const auto& component : components) {
+        ThrowIfCancelled();
+        AddProgressDone();
+        ComponentCoverage coverage;
+        coverage.name = component;
+
+        std::string headerPath = ComponentHeaderPath(component);
+        if (IsFileExists(headerPath)) {
+            std::string header = GetFileContent(headerPath);
+            for (const auto& symbol : ScanComponentDeclarations(header)) {
+                ++coverage.declared;
+                ++declaringComponents[std::string(symbol.name)];
+                const DefinitionEntry* entry = index.Find(symbol.name);
+                if (entry && !entry->isStub) ++coverage.implemented;
+                else if (entry) coverage.stillStubbed.emplace_back(symbol.name);
+            }
+        }
+        report.components.push_back(std::move(coverage));
+    }
+
+    for (const auto& entry : index.Entries()) {
+        if (!entry.isStub && !declaringComponents.contains(std::string(entry.name))) {
+            report.missingDeclaration.emplace_back(entry.name);
+        }
+    }
+    return report;
+}
+
+static void AppendJsonStringArray(std::ostream& out, const std::vector<std::string>& values) {
+    out << "[";
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i ? ", " : "") << "\"" << values[i] << "\"";
+    }
+    out << "]";
+}
+
+static void PrintCoverageJson(const CoverageReport& report) {
+    std::cout << "{\n";
+    std::cout << "  \"total\": " << report.totalFunctions << ",\n";
+    std::cout << "  \"implemented\": " << report.implementedFunctions << ",\n";
+    std::cout << "  \"stubs\": " << report.stubFunctions << ",\n";
+    std::cout << "  \"components\": [";
+    for (size_t i = 0; i < report.components.size(); ++i) {
+        const auto& component = report.components[i];
+        std::cout << (i ? ",\n" : "\n") << "    {\"name\": \"" << component.name << "\", \"declared\": " << component.declared
+            << ", \"implemented\": " << component.implemented << ", \"still_stubbed\": ";
+        AppendJsonStringArray(std::cout, component.stillStubbed);
+        std::cout << "}";
+    }
+    std::cout << (report.components.empty() ? "],\n" : "\n  ],\n");
+    std::cout << "  \"implemented_missing_declaration\": ";
+    AppendJsonStringArray(std::cout, report.missingDeclaration);
+    std::cout << "\n}" << std::endl;
+}
+
+static void PrintCoverageTable(const CoverageReport& report) {
+    double percent = report.totalFunctions ? 100.0 * report.implementedFunctions / report.totalFunctions : 0.0;
+    std::cout << "Definitions: " << report.totalFunctions << " functions, " << report.implementedFunctions
+        << " implemented (" << std::fixed << std::setprecision(1) << percent << std::defaultfloat << "%), "
+        << report.stubFunctions << " stubs" << std::endl;
+
+    if (!report.components.empty()) {
+        std::cout << std::endl << std::left << std::setw(32) << "Component" << std::right
+            << std::setw(10) << "Declared" << std::setw(13) << "Implemented" << std::setw(10) << "Stubbed" << std::endl;
+        for (const auto& component : report.components) {
+            std::cout << std::left << std::setw(32) << component.name << std::right
+                << std::setw(10) << component.declared << std::setw(13) << component.implemented
+                << std::setw(10) << component.stillStubbed.size() << std::endl;
+        }
+    }
+
+    bool hasStubbed = false;
+    for (const auto& component : report.components) {
+        if (component.stillStubbed.empty()) continue;
+        if (!hasStubbed) std::cout << std::endl << "Declared but still stubbed in Definitions:" << std::endl;
+        hasStubbed = true;
+        std::cout << "  " << component.name << ":";
+        for (const auto& name : component.stillStubbed) std::cout << " " << name;
+        std::cout << std::endl;
+    }
+
+    if (!report.missingDeclaration.empty()) {
+        std::cout << std::endl << "Implemented but declared by no component:" << std::endl << " ";
+        for (const auto& name : report.missingDeclaration) std::cout << " " << name;
+        std::cout << std::endl;
+    }
+}
+
+int CMD_coverage(const std::vector<std::string>& args) {
+    bool json = false;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--json") {
+            json = true;
+        } else {
+            std::cout << "Usage: coverage [--json]" << std::endl;
+            return COMMAND_USAGE_ERROR;
+        }
+    }
+
+    if (!IsFileExists(DEFINITIONS_FILE_PATH)) {
+        std::cerr << "Definitions file does not exist '" << DEFINITIONS_FILE_PATH << "'" << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    try {
+        CoverageReport report = BuildCoverageReport();
+        if (json) PrintCoverageJson(report);
+        else PrintCoverageTable(report);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
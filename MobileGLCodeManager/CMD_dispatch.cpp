@@ -0,0 +1,281 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "CMD_dispatch.h"
+#include "CMD_implementFunction.h"
+#include "Commands.h"
+#include "DefinitionIndex.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+
+const char* DISPATCH_HEADER_FILE_PATH = "MobileGL/MG_Impl/GLImpl/Exporting/GLDispatchTable.h";
+
+// Seeds are tried in order until a bucket fits; with four names per bucket on
+// average this ends after a few hundred tries even for the largest buckets.
+static constexpr uint32_t MAX_SEED = 1u << 24;
+
+// Eight bytes per step, assembled with shifts rather than memcpy so the copy in
+// the generated header stays constexpr; compilers fold them into a single load.
+uint32_t PerfectHash::Hash(std::string_view text) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ text.size();
+    size_t i = 0;
+    while (i < text.size()) {
+        uint64_t word = 0;
+        for (size_t b = 0; b < 8 && i < text.size(); ++b, ++i) word |= uint64_t(static_cast<unsigned char>(text[i])) << (8 * b);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    return static_cast<uint32_t>(h);
+}
+
+uint32_t PerfectHash::Mix(uint32_t hash, uint32_t seed) {
+    uint32_t h = hash ^ (seed * 0x9E3779B9u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Maps a hash onto [0, count) with a multiply instead of a division.
+static uint32_t Reduce(uint32_t hash, size_t count) {
+    return static_cast<uint32_t>((uint64_t(hash) * count) >> 32);
+}
+
+// The same functions as PerfectHash::Hash, PerfectHash::Mix and Reduce, as emitted into
+// the generated header.
+static const char* GENERATED_HASH_FUNCTIONS = R"gen(    constexpr std::uint32_t Hash(std::string_view text) {
+        std::uint64_t h = 0x9E3779B97F4A7C15ull ^ text.size();
+        std::size_t i = 0;
+        while (i < text.size()) {
+            std::uint64_t word = 0;
+            for (std::size_t b = 0; b < 8 && i < text.size(); ++b, ++i) word |= std::uint64_t(static_cast<unsigned char>(text[i])) << (8 * b);
+            h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+            h ^= h >> 32;
+        }
+        return static_cast<std::uint32_t>(h);
+    }
+
+    constexpr std::uint32_t Mix(std::uint32_t hash, std::uint32_t seed) {
+        std::uint32_t h = hash ^ (seed * 0x9E3779B9u);
+        h ^= h >> 16;
+        h *= 0x85EBCA6Bu;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    constexpr std::uint32_t Reduce(std::uint32_t hash, std::size_t count) {
+        return static_cast<std::uint32_t>((std::uint64_t(hash) * count) >> 32);
+    }
+)gen";
+
+void PerfectHash::Build(const std::vector<std::string_view>& names) {
+    ScopedTimer timer("PerfectHash::Build");
+
+    // Names are hashed once; every seed only remixes that hash. Two names with
+    // the same hash could never be told apart, so they are refused up front.
+    std::vector<uint32_t> hashes(names.size());
+    std::unordered_map<uint32_t, std::string_view> byHash;
+    for (size_t i = 0; i < names.size(); ++i) {
+        hashes[i] = Hash(names[i]);
+        auto [it, inserted] = byHash.emplace(hashes[i], names[i]);
+        if (inserted) continue;
+        if (it->second == names[i]) throw std::runtime_error("Duplicate function name '" + std::string(names[i]) + "'");
+        throw std::runtime_error("Function names '" + std::string(it->second) + "' and '" + std::string(names[i]) + "' have the same hash");
+    }
+
+    const size_t count = names.size();
+    seeds.assign(std::max<size_t>(1, (count + 3) / 4), 0);
+    slots.assign(count, 0);
+    if (count == 0) return;
+
+    std::vector<std::vector<uint32_t>> buckets(seeds.size());
+    for (size_t i = 0; i < count; ++i) {
+        buckets[Reduce(Mix(hashes[i], 0), buckets.size())].push_back(static_cast<uint32_t>(i));
+    }
+    // Largest buckets first, while most slots are still free. Ties keep bucket
+    // order, so the result depends only on the names.
+    std::vector<uint32_t> order(buckets.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<bool> taken(count, false);
+    std::vector<uint32_t> candidate;
+    size_t next = 0;
+    for (; next < order.size() && buckets[order[next]].size() > 1; ++next) {
+        const auto& bucket = buckets[order[next]];
+        for (uint32_t seed = 1;; ++seed) {
+            if (seed > MAX_SEED) throw std::runtime_error("Could not build a perfect hash over the function names");
+            candidate.clear();
+            for (uint32_t key : bucket) {
+                uint32_t slot = Reduce(Mix(hashes[key], seed), count);
+                if (taken[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) break;
+                candidate.push_back(slot);
+            }
+            if (candidate.size() != bucket.size()) continue;
+
+            for (size_t k = 0; k < bucket.size(); ++k) {
+                taken[candidate[k]] = true;
+                slots[bucket[k]] = candidate[k];
+            }
+            seeds[order[next]] = static_cast<int32_t>(seed);
+            break;
+        }
+    }
+
+    // Single-name buckets take the remaining slots directly.
+    uint32_t freeSlot = 0;
+    for (; next < order.size() && !buckets[order[next]].empty(); ++next) {
+        while (taken[freeSlot]) ++freeSlot;
+        taken[freeSlot] = true;
+        slots[buckets[order[next]][0]] = freeSlot;
+        seeds[order[next]] = -static_cast<int32_t>(freeSlot) - 1;
+    }
+}
+
+uint32_t PerfectHash::Slot(std::string_view name) const {
+    if (slots.empty()) return 0;
+    uint32_t hash = Hash(name);
+    int32_t seed = seeds[Reduce(Mix(hash, 0), seeds.size())];
+    return seed < 0 ? static_cast<uint32_t>(-seed - 1) : Reduce(Mix(hash, static_cast<uint32_t>(seed)), slots.size());
+}
+
+std::string GenerateDispatchHeader(const DefinitionIndex& index) {
+    ScopedTimer timer("GenerateDispatchHeader");
+
+    const auto& entries = index.Entries();
+    if (entries.empty()) {
+        throw std::runtime_error("No functions in definitions file '" + std::string(DEFINITIONS_FILE_PATH) + "'");
+    }
+
+    std::vector<std::string_view> names;
+    names.reserve(entries.size());
+    for (const auto& entry : entries) names.push_back(entry.name);
+    PerfectHash hash;
+    hash.Build(names);
+
+    std::vector<const DefinitionEntry*> bySlot(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) bySlot[hash.SlotOf(i)] = &entries[i];
+
+    std::string out;
+    out.reserve(entries.size() * 96);
+    out += "// Generated by MobileGLCodeManager ('dispatch') from Definitions.cpp. Do not edit;\n"
+        "// 'impl' regenerates this file whenever it changes the stub state of a function.\n"
+        "#pragma once\n"
+        "#include <cstddef>\n"
+        "#include <cstdint>\n"
+        "#include <string_view>\n"
+        "\n"
+        "// Entry points are taken through these macros. The defaults need every GL entry\n"
+        "// point declared; define them before including this header to map elsewhere,\n"
+        "// e.g. MG_GL_DISPATCH_STUB(name) as nullptr to hide unimplemented functions.\n"
+        "#ifndef MG_GL_DISPATCH_IMPL\n"
+        "#define MG_GL_DISPATCH_IMPL(name) reinterpret_cast<::MobileGL::GLDispatch::Proc>(&::name)\n"
+        "#endif\n"
+        "#ifndef MG_GL_DISPATCH_STUB\n"
+        "#define MG_GL_DISPATCH_STUB(name) MG_GL_DISPATCH_IMPL(name)\n"
+        "#endif\n"
+        "\n"
+        "namespace MobileGL::GLDispatch {\n"
+        "    using Proc = void (*)();\n"
+        "\n";
+    out += "    inline constexpr std::size_t FunctionCount = " + std::to_string(entries.size()) + ";\n";
+    out += "    inline constexpr std::size_t BucketCount = " + std::to_string(hash.Seeds().size()) + ";\n\n";
+    out += GENERATED_HASH_FUNCTIONS;
+
+    out += "\n    // Per bucket of Reduce(Mix(Hash(name), 0)): the seed that spreads its names over distinct\n"
+        "    // slots, or -slot - 1 for a bucket with a single name.\n"
+        "    inline constexpr std::int32_t Seeds[BucketCount] = {";
+    const auto& seeds = hash.Seeds();
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        out += i % 12 == 0 ? "\n        " : " ";
+        out += std::to_string(seeds[i]);
+        out += ",";
+    }
+    out += "\n    };\n\n    // By slot.\n    inline constexpr std::string_view Names[FunctionCount] = {\n";
+    for (const DefinitionEntry* entry : bySlot) {
+        out += "        \"";
+        out += entry->name;
+        out += "\",\n";
+    }
+    out += "    };\n\n    inline constexpr bool IsStub[FunctionCount] = {";
+    for (size_t i = 0; i < bySlot.size(); ++i) {
+        out += i % 8 == 0 ? "\n        " : " ";
+        out += bySlot[i]->isStub ? "true," : "false,";
+    }
+    out += "\n    };\n\n"
+        "    // Slot of a GL function name, or -1 if MobileGL does not define it.\n"
+        "    constexpr int Find(std::string_view name) {\n"
+        "        std::uint32_t hash = Hash(name);\n"
+        "        std::int32_t seed = Seeds[Reduce(Mix(hash, 0), BucketCount)];\n"
+        "        std::uint32_t slot = seed < 0 ? static_cast<std::uint32_t>(-seed - 1)\n"
+        "                                      : Reduce(Mix(hash, static_cast<std::uint32_t>(seed)), FunctionCount);\n"
+        "        return Names[slot] == name ? static_cast<int>(slot) : -1;\n"
+        "    }\n"
+        "\n"
+        "    inline const Proc Procs[FunctionCount] = {\n";
+    for (const DefinitionEntry* entry : bySlot) {
+        out += entry->isStub ? "        MG_GL_DISPATCH_STUB(" : "        MG_GL_DISPATCH_IMPL(";
+        out += entry->name;
+        out += "),\n";
+    }
+    out += "    };\n"
+        "\n"
+        "    inline Proc GetProcAddress(std::string_view name) {\n"
+        "        int slot = Find(name);\n"
+        "        return slot < 0 ? nullptr : Procs[slot];\n"
+        "    }\n"
+        "} // namespace MobileGL::GLDispatch\n"
+        "\n";
+    out += "static_assert(MobileGL::GLDispatch::Find(\"";
+    out += entries.front().name;
+    out += "\") == " + std::to_string(hash.SlotOf(0)) + ", \"GL dispatch hash is out of sync\");\n";
+    return out;
+}
+
+std::optional<std::string> RenderDispatchHeaderUpdate(const DefinitionIndex& index) {
+    if (!IsFileExists(DISPATCH_HEADER_FILE_PATH)) return std::nullopt;
+    ScopedTimer timer("RenderDispatchHeaderUpdate");
+    return GenerateDispatchHeader(index);
+}
+
+int CMD_dispatch(const std::vector<std::string>& args) {
+    if (args.size() > 2) {
+        std::cout << "Usage: dispatch [<output_file>]" << std::endl;
+        std::cout << "Writes a GL entry-point dispatch header (default '" << DISPATCH_HEADER_FILE_PATH << "')." << std::endl;
+        std::cout << "Once the default header exists, impl keeps it up to date." << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+    std::string output = args.size() == 2 ? args[1] : DISPATCH_HEADER_FILE_PATH;
+
+    if (!IsFileExists(DEFINITIONS_FILE_PATH)) {
+        std::cerr << "Definitions file does not exist '" << DEFINITIONS_FILE_PATH << "'" << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    try {
+        const DefinitionIndex& index = GetDefinitionIndex(DEFINITIONS_FILE_PATH);
+        size_t stubs = std::count_if(index.Entries().begin(), index.Entries().end(), [](const DefinitionEntry& entry) {
+            return entry.isStub;
+        });
+        bool written = WriteToFile(output, GenerateDispatchHeader(index));
+        std::cout << (written ? "Wrote '" : "Up to date '") << output << "' (" << index.Entries().size()
+            << " functions, " << stubs << " stubs)" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
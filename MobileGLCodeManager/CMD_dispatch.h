@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+class DefinitionIndex;
+
+// Default location of the generated GL entry-point dispatch header.
+extern const char* DISPATCH_HEADER_FILE_PATH;
+
+// Minimal perfect hash over a fixed set of names ("hash and displace"). Names
+// are hashed once and grouped into buckets by Mix(Hash(name), 0); each bucket stores either a seed
+// that sends all of its names to distinct free slots, or (for single-name
+// buckets) the slot itself, encoded as -slot - 1. Every name gets its own slot
+// in [0, Size()).
+class PerfectHash {
+public:
+    // Throws std::runtime_error on duplicate names, or names with equal Hash.
+    void Build(const std::vector<std::string_view>& names);
+
+    // The slot 'name' maps to. Names that were not passed to Build land on some
+    // slot too, so callers compare against the name stored there.
+    uint32_t Slot(std::string_view name) const;
+    // Slot of the i-th name passed to Build.
+    uint32_t SlotOf(size_t i) const { return slots[i]; }
+    const std::vector<int32_t>& Seeds() const { return seeds; }
+    size_t Size() const { return slots.size(); }
+
+    // Must match the Hash and Mix emitted into the generated header.
+    static uint32_t Hash(std::string_view text);
+    static uint32_t Mix(uint32_t hash, uint32_t seed);
+
+private:
+    std::vector<int32_t> seeds; // per bucket
+    std::vector<uint32_t> slots; // per name
+};
+
+// Renders the dispatch header for every function in the index: a constexpr
+// perfect hash from GL function name to slot, the stub state of each function,
+// and a table of entry-point pointers. The output depends only on the index,
+// so regenerating it for unchanged definitions gives identical bytes.
+std::string GenerateDispatchHeader(const DefinitionIndex& index);
+
+// Renders DISPATCH_HEADER_FILE_PATH for 'index' if the workspace has one, after
+// the stub state in the definitions file changed. Callers render it before
+// writing anything, since GenerateDispatchHeader can throw, and write it along
+// with the definitions file it reflects.
+std::optional<std::string> RenderDispatchHeaderUpdate(const DefinitionIndex& index);
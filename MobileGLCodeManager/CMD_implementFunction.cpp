@@ -6,15 +6,38 @@
 #include <fstream>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <algorithm>
 #include <filesystem>
-#include <regex>
+#include <string_view>
+#include <cctype>
+#include <optional>
+
+#include "CMD_implementFunction.h"
+#include "CMD_dispatch.h"
+#include "CMD_profile.h"
+#include "CMD_unity.h"
+#include "CodeTemplate.h"
+#include "DefinitionIndex.h"
+#include "DefinitionScanner.h"
+#include "FileUtils.h"
+#include "SymbolIndex.h"
+#include "ThreadPool.h"
+#include "TypeHeaders.h"
+#include "Instrumentation.h"
+#include "Progress.h"
 
 const char* GL_IMPL_DIRECTORY_PATH = "MobileGL/MG_Impl/GLImpl";
 const char* DEFINITIONS_FILE_PATH = "MobileGL/MG_Impl/GLImpl/Exporting/Definitions.cpp";
 const char* CMAKELISTS_FILE_PATH = "CMakeLists.txt";
 
-const char* INIT_HEADER_FILE_CONTENT = R"init(#pragma once
-#include <Includes.h>
+const char* TEMPLATES_DIRECTORY_PATH = "CodeManagerTemplates";
+
+// Built-in templates; TEMPLATES_DIRECTORY_PATH/<file> replaces one for every
+// component, TEMPLATES_DIRECTORY_PATH/<component>/<file> for a single one.
+const char* HEADER_TEMPLATE_FILE = "component_header.tmpl";
+constexpr std::string_view DEFAULT_HEADER_TEMPLATE = R"init(#pragma once
+{{includes}}
 
 namespace MobileGL {
     namespace MG_Impl::GLImpl {
@@ -22,7 +45,8 @@ namespace MobileGL {
     } // namespace MG_Impl::GLImpl
 } // namespace MobileGL)init";
 
-const char* INIT_SOURCE_CODE_FILE_CONTENT = R"init(
+const char* SOURCE_TEMPLATE_FILE = "component_source.tmpl";
+constexpr std::string_view DEFAULT_SOURCE_TEMPLATE = R"init(#include "GL_{{component}}.h"
 
 namespace MobileGL {
     namespace MG_Impl::GLImpl {
@@ -30,279 +54,558 @@ namespace MobileGL {
     } // namespace MG_Impl::GLImpl
 } // namespace MobileGL)init";
 
+const char* DECLARATION_TEMPLATE_FILE = "declaration.tmpl";
+constexpr std::string_view DEFAULT_DECLARATION_TEMPLATE = "{{return_type}} {{name}}({{params}});";
+
+const char* DEFINITION_TEMPLATE_FILE = "definition.tmpl";
+constexpr std::string_view DEFAULT_DEFINITION_TEMPLATE = R"init({{return_type}} {{name}}({{params}}) {
+    // TODO: implement
+}
+)init";
+
+// What {{includes}} expands to: the catch-all include, or with a type map the
+// insertion point below which the headers the declarations need are kept.
+const char* DEFAULT_COMPONENT_INCLUDE = "#include <Includes.h>";
+const char* INSERTION_POINT_INCLUDE = "/* @INSERTION_POINT:INCLUDE@ */";
 const char* INSERTION_POINT_FUNCTION_DECLARATION = "/* @INSERTION_POINT:FUNCTION_DECLARATION@ */";
 const char* INSERTION_POINT_FUNCTION_IMPLEMENTATION = "/* @INSERTION_POINT:FUNCTION_IMPLEMENTATION@ */";
 const char* INSERTION_POINT_SOURCE_FILE_GLIMPL = "# @INSERTION_POINT:SOURCE_FILE_GLIMPL@ #";
 
 
-namespace fs = std::filesystem;
-
-bool EnsureFileAndDirsExist(const std::string& pathStr) {
-    fs::path filePath(pathStr);
-    fs::path dirPath = filePath.parent_path();
+void SetFunctionStub(const std::string& filename, const std::string& func_name, bool is_stub) {
+    ScopedTimer timer("SetFunctionStub");
 
-    if (!dirPath.empty() && !fs::exists(dirPath)) {
-        if (!fs::create_directories(dirPath)) {
-            std::cerr << "Failed to create directories: " << dirPath << std::endl;
-            return false;
-        }
+    const DefinitionIndex& index = GetDefinitionIndex(filename);
+    const DefinitionEntry* entry = index.Find(func_name);
+    if (!entry) {
+        return;
     }
 
-    if (!fs::exists(filePath)) {
-        std::ofstream ofs(filePath);
-        if (!ofs) {
-            std::cerr << "Failed to create file: " << filePath << std::endl;
-            return false;
-        }
+    std::string content = index.Content();
+    if (SetFunctionStubsInContent(content, { entry }, is_stub)) {
+        DefinitionIndex updated;
+        updated.Build(std::move(content));
+        std::optional<std::string> dispatchHeader = RenderDispatchHeaderUpdate(updated);
+        WriteToFile(filename, updated.Content());
+        UpdateDefinitionIndex(filename, updated);
+        if (dispatchHeader) WriteToFile(DISPATCH_HEADER_FILE_PATH, *dispatchHeader);
     }
-
-    return true;
 }
 
-bool IsFileExists(const std::string& pathStr) {
-    fs::path filePath(pathStr);
-    return fs::exists(filePath) && fs::is_regular_file(filePath);
-}
-
-std::string GetFileContent(const std::string& filename) {
-    std::ifstream inFile(filename);
-    if (!inFile.is_open()) {
-        throw std::runtime_error("Cannot open file: " + filename);
-    }
-    std::string content;
-    std::string line;
-    while (std::getline(inFile, line)) {
-        content += line + '\n';
+bool AddGLImplSourceToCMakeListsContent(std::string& cmakeContent, const std::string& sourcePath) {
+    size_t insertPos = cmakeContent.find(INSERTION_POINT_SOURCE_FILE_GLIMPL);
+    if (insertPos == std::string::npos) {
+        throw std::runtime_error("Insertion point not found in CMakeLists file");
     }
-    inFile.close();
-	return content;
-}
 
-void WriteToFile(const std::string& filename, const std::string& content) {
-    std::ofstream outFile(filename);
-    if (!outFile.is_open()) {
-        throw std::runtime_error("Cannot write to file: " + filename);
+    if (cmakeContent.find(sourcePath) != std::string::npos) {
+        return false;
     }
-    outFile << content;
-    outFile.close();
+
+    size_t lineStart = cmakeContent.rfind('\n', insertPos) + 1;
+    std::string_view indent = std::string_view(cmakeContent).substr(lineStart, insertPos - lineStart);
+
+    std::string insertion;
+    insertion += DetectNewline(cmakeContent);
+    insertion += indent;
+    insertion += sourcePath;
+    cmakeContent.insert(insertPos + strlen(INSERTION_POINT_SOURCE_FILE_GLIMPL), insertion);
+
+    std::cout << "Added source to CMakeLists '" << sourcePath << "'" << std::endl;
+    return true;
 }
 
-void SetFunctionStub(const std::string& filename, const std::string& func_name, bool is_stub) {
-    std::ifstream inFile(filename);
-    if (!inFile.is_open()) {
-        throw std::runtime_error("Cannot open file: " + filename);
-    }
+// In a unity build the component goes into a unity file instead, whose new
+// content is added to 'unityUpdates'.
+bool AddSourceToCMakeListsContent(std::string& cmakeContent, const std::string& component, UnityFileUpdates& unityUpdates) {
+    ScopedTimer timer("AddSourceToCMakeListsContent");
 
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(inFile, line)) {
-        lines.push_back(line);
-    }
-    inFile.close();
-
-    std::string pattern_str =
-        "(DECLARE_GL_FUNCTION_(?:STUB_)?HEAD\\([^)]*\\b" +
-        func_name +
-        "\\b[^)]*\\)\\s*DECLARE_GL_FUNCTION_(?:STUB_)?(?:END|END_NO_RETURN)[^)]*\\([^)]*\\b" +
-        func_name +
-        "\\b[^)]*\\))";
-
-    std::regex func_pattern(pattern_str);
-
-    for (auto& line : lines) {
-        if (std::regex_search(line, func_pattern)) {
-            if (is_stub) {
-                size_t pos;
-                if ((pos = line.find("DECLARE_GL_FUNCTION_HEAD")) != std::string::npos) {
-                    line.replace(pos, strlen("DECLARE_GL_FUNCTION_HEAD"), "DECLARE_GL_FUNCTION_STUB_HEAD");
-                }
-                if ((pos = line.find("DECLARE_GL_FUNCTION_END")) != std::string::npos) {
-                    line.replace(pos, strlen("DECLARE_GL_FUNCTION_END"), "DECLARE_GL_FUNCTION_STUB_END");
-                }
-            }
-            else {
-                size_t pos;
-                if ((pos = line.find("DECLARE_GL_FUNCTION_STUB_HEAD")) != std::string::npos) {
-                    line.replace(pos, strlen("DECLARE_GL_FUNCTION_STUB_HEAD"), "DECLARE_GL_FUNCTION_HEAD");
-                }
-                if ((pos = line.find("DECLARE_GL_FUNCTION_STUB_END")) != std::string::npos) {
-                    line.replace(pos, strlen("DECLARE_GL_FUNCTION_STUB_END"), "DECLARE_GL_FUNCTION_END");
-                }
-            }
-        }
+    if (cmakeContent.find(INSERTION_POINT_SOURCE_FILE_GLIMPL) == std::string::npos) {
+        throw std::runtime_error("Insertion point not found in CMakeLists file");
     }
 
-    std::ofstream outFile(filename);
-    if (!outFile.is_open()) {
-        throw std::runtime_error("Cannot write to file: " + filename);
+    std::string sourcePath = "MobileGL/MG_Impl/GLImpl/" + component + "/GL_" + component + ".cpp";
+    if (cmakeContent.find(sourcePath) != std::string::npos) {
+        return false;
     }
-    for (const auto& l : lines) {
-        outFile << l << '\n';
+    // In a unity build the source goes into a unity file, which is already listed.
+    if (IsUnityBuildActive(cmakeContent)) {
+        AddComponentToUnityBuild(cmakeContent, component, unityUpdates);
+        return false;
     }
-    outFile.close();
+    return AddGLImplSourceToCMakeListsContent(cmakeContent, sourcePath);
 }
 
 void MakeSureSourceInCMakeListsFile(const std::string& component) {
+    ScopedTimer timer("MakeSureSourceInCMakeListsFile");
+
     if (!IsFileExists(CMAKELISTS_FILE_PATH)) {
         std::cerr << "CMakeLists file does not exist: " << CMAKELISTS_FILE_PATH << std::endl;
         return;
     }
 
     std::string cmakeContent = GetFileContent(CMAKELISTS_FILE_PATH);
-
-    size_t insertPos = cmakeContent.find(INSERTION_POINT_SOURCE_FILE_GLIMPL);
-    if (insertPos == std::string::npos) {
-        throw std::runtime_error("Insertion point not found in CMakeLists file");
+    UnityFileUpdates unityUpdates;
+    bool cmakeChanged = AddSourceToCMakeListsContent(cmakeContent, component, unityUpdates);
+    for (const auto& [path, content] : unityUpdates) WriteToFile(path, content);
+    if (cmakeChanged) {
+        WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
     }
+}
 
-    std::string sourcePath = "MobileGL/MG_Impl/GLImpl/" + component + "/GL_" + component + ".cpp";
-
-    if (cmakeContent.find(sourcePath) != std::string::npos) {
-        return;
+FunctionSignature MakeFunctionSignature(const DefinitionEntry& entry) {
+    FunctionSignature signature;
+    signature.returnType = entry.returnType;
+    signature.name = entry.name;
+    for (const auto& param : entry.params) {
+        if (!signature.params.empty()) signature.params += ", ";
+        signature.params += param;
+
+        // The name is the last identifier, ahead of any array bounds: "const GLfloat v[4]" -> "v".
+        std::string_view declarator = param.substr(0, param.find('['));
+        size_t end = declarator.find_last_not_of(" \t");
+        if (end == std::string_view::npos) continue;
+        size_t begin = end + 1;
+        while (begin > 0 && (std::isalnum(static_cast<unsigned char>(declarator[begin - 1])) || declarator[begin - 1] == '_')) --begin;
+        std::string_view name = declarator.substr(begin, end + 1 - begin);
+        if (name.empty() || name == "void" || begin == 0) continue;
+        if (!signature.args.empty()) signature.args += ", ";
+        signature.args += name;
     }
+    return signature;
+}
 
-    size_t lineStart = cmakeContent.rfind('\n', insertPos) + 1;
-    std::string indent = cmakeContent.substr(lineStart, insertPos - lineStart);
+FunctionSignature FindFunctionSignature(const DefinitionIndex& index, const std::string& functionName) {
+    const DefinitionEntry* entry = index.Find(functionName);
+    if (!entry) {
+        throw std::runtime_error("Function not found in definitions: " + functionName);
+    }
+    return MakeFunctionSignature(*entry);
+}
 
-    cmakeContent.insert(insertPos + strlen(INSERTION_POINT_SOURCE_FILE_GLIMPL),
-        "\n" + indent + sourcePath);
+ComponentFiles LoadComponentFiles(const std::string& component) {
+    ScopedTimer timer("LoadComponentFiles");
 
-    WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
+    ComponentFiles files;
+    files.component = component;
+    files.filePathPrefix = std::string(GL_IMPL_DIRECTORY_PATH) + "/" + component + "/GL_" + component;
 
-    std::cout << "Added source to CMakeLists '" << sourcePath << "'" << std::endl;
-}
+    if (IsFileExists(files.filePathPrefix + ".h")) {
+        files.header = GetFileContent(files.filePathPrefix + ".h");
+    }
+    TemplateValues values;
+    values.component = component;
+    values.includes = LoadTypeHeaderMap() ? INSERTION_POINT_INCLUDE : DEFAULT_COMPONENT_INCLUDE;
+    if (files.header.empty()) {
+        auto headerTemplate = LoadCodeTemplate(HEADER_TEMPLATE_FILE, component, DEFAULT_HEADER_TEMPLATE);
+        headerTemplate->Expand(files.header, values, headerTemplate->Newline());
+    }
 
-void replaceFirstLine(std::string& content, const std::string& newFirstLine) {
-    size_t pos = content.find('\n');
-    if (pos == std::string::npos) {
-        content = newFirstLine;
-    } else {
-        content = newFirstLine + content.substr(pos);
+    if (IsFileExists(files.filePathPrefix + ".cpp")) {
+        files.source = GetFileContent(files.filePathPrefix + ".cpp");
     }
+    if (files.source.empty()) {
+        auto sourceTemplate = LoadCodeTemplate(SOURCE_TEMPLATE_FILE, component, DEFAULT_SOURCE_TEMPLATE);
+        sourceTemplate->Expand(files.source, values, sourceTemplate->Newline());
+    }
+    return files;
 }
 
-void WriteSourceAndHeaderFiles(const std::string& functionName, const std::string& component) {
-    std::string filePathPrefix = std::string(GL_IMPL_DIRECTORY_PATH) + "/" + component + "/GL_" + component;
-
-    EnsureFileAndDirsExist(filePathPrefix + ".h");
-    std::string headerfileContent = GetFileContent(filePathPrefix + ".h");
-    if (headerfileContent.empty()) {
-        WriteToFile(filePathPrefix + ".h", INIT_HEADER_FILE_CONTENT);
-        headerfileContent = INIT_HEADER_FILE_CONTENT;
+bool SetComponentIncludes(std::string& header, std::vector<std::string> headers, bool merge) {
+    size_t pos = header.find(INSERTION_POINT_INCLUDE);
+    if (pos == std::string::npos) return false;
+    std::string_view newline = DetectNewline(header);
+
+    // The include lines directly below the insertion point.
+    size_t blockStart = pos + strlen(INSERTION_POINT_INCLUDE);
+    size_t blockEnd = blockStart;
+    while (std::string_view(header).substr(blockEnd).starts_with(std::string(newline) + "#include ")) {
+        size_t lineStart = blockEnd + newline.size();
+        size_t lineEnd = header.find(newline, lineStart);
+        if (lineEnd == std::string::npos) lineEnd = header.size();
+        if (merge) headers.push_back(header.substr(lineStart + strlen("#include "), lineEnd - lineStart - strlen("#include ")));
+        blockEnd = lineEnd;
     }
-
-    EnsureFileAndDirsExist(filePathPrefix + ".cpp");
-    std::string sourcefileContent = GetFileContent(filePathPrefix + ".cpp");
-    if (sourcefileContent.empty()) {
-        std::string realContent = INIT_SOURCE_CODE_FILE_CONTENT;
-        replaceFirstLine(realContent, "#include \"GL_" + component + ".h\"");
-        WriteToFile(filePathPrefix + ".cpp", realContent);
-        sourcefileContent = realContent;
+    std::sort(headers.begin(), headers.end());
+    headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+
+    std::string block;
+    for (const auto& include : headers) {
+        block += newline;
+        block += "#include ";
+        block += include;
     }
+    if (header.compare(blockStart, blockEnd - blockStart, block) == 0) return false;
+    header.replace(blockStart, blockEnd - blockStart, block);
+    return true;
+}
 
-    MakeSureSourceInCMakeListsFile(component);
+void InsertFunctionsIntoComponent(ComponentFiles& files, const std::vector<FunctionInsertion>& insertions) {
+    ScopedTimer timer("InsertFunctionsIntoComponent");
 
-    std::string definitionsContent = GetFileContent(DEFINITIONS_FILE_PATH);
-    std::istringstream defStream(definitionsContent);
-    std::string line;
-    std::string functionSignature;
+    bool needsHeader = std::any_of(insertions.begin(), insertions.end(), [](const FunctionInsertion& insertion) { return insertion.declare; });
+    bool needsSource = std::any_of(insertions.begin(), insertions.end(), [](const FunctionInsertion& insertion) { return insertion.define; });
 
-    std::regex funcLinePattern("DECLARE_GL_FUNCTION_HEAD\\(([^)]*\\b" + functionName + "\\b[^)]*)\\)");
+    size_t headerPos = files.header.find(INSERTION_POINT_FUNCTION_DECLARATION);
+    if (needsHeader && headerPos == std::string::npos) {
+        throw std::runtime_error("Insertion point not found in header '" + files.filePathPrefix + ".h'");
+    }
 
-    while (std::getline(defStream, line)) {
-        std::smatch match;
-        if (std::regex_search(line, match, funcLinePattern)) {
-            functionSignature = match[1].str();
-            break;
-        }
+    size_t sourcePos = files.source.find(INSERTION_POINT_FUNCTION_IMPLEMENTATION);
+    if (needsSource && sourcePos == std::string::npos) {
+        throw std::runtime_error("Insertion point not found in source' " + files.filePathPrefix + ".cpp'");
     }
 
-    if (functionSignature.empty()) {
-        throw std::runtime_error("Function not found in definitions: " + functionName);
+    std::string_view headerIndent;
+    std::string_view headerNewline = DetectNewline(files.header);
+    if (needsHeader) {
+        size_t lineStart = files.header.rfind('\n', headerPos) + 1;
+        headerIndent = std::string_view(files.header).substr(lineStart, headerPos - lineStart);
     }
 
-    std::istringstream sigStream(functionSignature);
-    std::vector<std::string> parts;
-    std::string part;
+    std::string_view sourceIndent;
+    std::string_view sourceNewline = DetectNewline(files.source);
+    if (needsSource) {
+        size_t lineStart = files.source.rfind('\n', sourcePos) + 1;
+        sourceIndent = std::string_view(files.source).substr(lineStart, sourcePos - lineStart);
+    }
 
-    while (std::getline(sigStream, part, ',')) {
-        parts.push_back(part);
+    auto declarationTemplate = LoadCodeTemplate(DECLARATION_TEMPLATE_FILE, files.component, DEFAULT_DECLARATION_TEMPLATE);
+    auto definitionTemplate = LoadCodeTemplate(DEFINITION_TEMPLATE_FILE, files.component, DEFAULT_DEFINITION_TEMPLATE);
+
+    // Every function is inserted right below the insertion point, so the most recently
+    // implemented one ends up on top. Build the blocks back to front to keep that order.
+    std::string declarations;
+    std::string definitions;
+    for (auto it = insertions.rbegin(); it != insertions.rend(); ++it) {
+        const FunctionSignature& sig = it->signature;
+        TemplateValues values;
+        values.returnType = sig.returnType;
+        values.name = sig.name;
+        values.params = sig.params;
+        values.args = sig.args;
+        values.component = files.component;
+        values.defaultReturn = sig.returnType == "void" ? "" : "return {};";
+
+        if (it->declare) {
+            declarations += headerNewline;
+            values.indent = headerIndent;
+            declarationTemplate->Expand(declarations, values, headerNewline);
+        }
+        if (it->define) {
+            definitions += sourceNewline;
+            values.indent = sourceIndent;
+            definitionTemplate->Expand(definitions, values, sourceNewline);
+        }
     }
 
-    if (parts.size() < 2) {
-        throw std::runtime_error("Invalid function signature: " + functionSignature);
+    if (needsHeader) files.header.insert(headerPos + strlen(INSERTION_POINT_FUNCTION_DECLARATION), declarations);
+    if (auto typeHeaders = LoadTypeHeaderMap(); typeHeaders && needsHeader) {
+        std::vector<std::string> headers;
+        for (const auto& insertion : insertions) {
+            if (!insertion.declare) continue;
+            const FunctionSignature& sig = insertion.signature;
+            for (auto& header : typeHeaders->HeadersFor(sig.returnType, SplitMacroArguments(sig.params))) headers.push_back(std::move(header));
+        }
+        SetComponentIncludes(files.header, std::move(headers), true);
     }
+    if (needsSource) files.source.insert(sourcePos + strlen(INSERTION_POINT_FUNCTION_IMPLEMENTATION), definitions);
+}
 
-    std::string returnType = parts[0];
-    std::string funcName = parts[1];
-    funcName.erase(0, 1);
+void SaveComponentFiles(const ComponentFiles& files) {
+    ScopedTimer timer("SaveComponentFiles");
 
-    std::string params;
-    for (size_t i = 2; i < parts.size(); ++i) {
-        if (!params.empty()) params += ", ";
-        parts[i].erase(0, 1);
-        params += parts[i];
-    }
+    WriteToFile(files.filePathPrefix + ".h", files.header);
+    WriteToFile(files.filePathPrefix + ".cpp", files.source);
+}
 
-    std::string funcDeclaration = returnType + " " + funcName + "(" + params + ");";
+void WriteSourceAndHeaderFiles(const std::string& functionName, const std::string& component) {
+    ScopedTimer timer("WriteSourceAndHeaderFiles");
 
-    size_t headerPos = headerfileContent.find(INSERTION_POINT_FUNCTION_DECLARATION);
-    if (headerPos == std::string::npos) {
-        throw std::runtime_error("Insertion point not found in header '" + filePathPrefix + ".h'");
-    }
+    FunctionInsertion insertion{ FindFunctionSignature(GetDefinitionIndex(DEFINITIONS_FILE_PATH), functionName) };
+    const ComponentSymbolSet& existing = GetComponentSymbols(component);
+    insertion.declare = !existing.declared.contains(functionName);
+    insertion.define = !existing.defined.contains(functionName);
 
-    size_t lineStart = headerfileContent.rfind('\n', headerPos) + 1;
-    std::string indent = headerfileContent.substr(lineStart, headerPos - lineStart);
+    MakeSureSourceInCMakeListsFile(component);
+    if (!insertion.declare && !insertion.define) return;
 
-    headerfileContent.insert(headerPos + strlen(INSERTION_POINT_FUNCTION_DECLARATION),
-        "\n" + indent + funcDeclaration);
+    ComponentFiles files = LoadComponentFiles(component);
+    InsertFunctionsIntoComponent(files, { insertion });
+    SaveComponentFiles(files);
+    UpdateComponentSymbols(component, files.header, files.source);
+}
 
-    size_t sourcePos = sourcefileContent.find(INSERTION_POINT_FUNCTION_IMPLEMENTATION);
-    if (sourcePos == std::string::npos) {
-        throw std::runtime_error("Insertion point not found in source' " + filePathPrefix + ".cpp'");
-    }
+std::vector<ImplRequest> ReadImplManifest(const std::string& filename) {
+    ScopedTimer timer("ReadImplManifest");
 
-    lineStart = sourcefileContent.rfind('\n', sourcePos) + 1;
-    indent = sourcefileContent.substr(lineStart, sourcePos - lineStart);
+    std::string content = GetFileContent(filename);
+    std::istringstream stream(content);
+    std::vector<ImplRequest> requests;
+    std::string line;
+    size_t lineNumber = 0;
 
-    std::string rawDef =
-        returnType + " " + funcName + "(" + params + ") {\n"
-        "    // TODO: implement\n"
-        "}\n";
+    while (std::getline(stream, line)) {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
 
-    std::string funcDefinition = indent +
-        std::regex_replace(rawDef, std::regex("\n"), "\n" + indent);
+        std::istringstream lineStream(line);
+        ImplRequest request;
+        if (!(lineStream >> request.functionName)) continue;
 
-    sourcefileContent.insert(
-        sourcePos + strlen(INSERTION_POINT_FUNCTION_IMPLEMENTATION),
-        "\n" + funcDefinition
-    );
+        std::string extra;
+        if (!(lineStream >> request.component) || (lineStream >> extra)) {
+            throw std::runtime_error("Invalid manifest entry at " + filename + ":" +
+                std::to_string(lineNumber) + ", expected '<function_name> <component>'");
+        }
+        requests.push_back(std::move(request));
+    }
+    return requests;
+}
 
-    WriteToFile(filePathPrefix + ".h", headerfileContent);
-    WriteToFile(filePathPrefix + ".cpp", sourcefileContent);
+ImplOptions& DefaultImplOptions() {
+    static ImplOptions options;
+    return options;
 }
 
-void implementFunction(const std::string& functionName, const std::string& component) {
+bool implementFunctions(const std::vector<ImplRequest>& requests, const ImplOptions& options) {
+    ScopedTimer timer("implementFunctions");
+
     if (!IsFileExists(DEFINITIONS_FILE_PATH)) {
         std::cerr << "Definitions file does not exist '" << DEFINITIONS_FILE_PATH << "'" << std::endl;
-        return;
+        return false;
     }
 
+    bool allSucceeded = true;
     try {
-        SetFunctionStub(DEFINITIONS_FILE_PATH, functionName, false);
+        const DefinitionIndex& index = GetDefinitionIndex(DEFINITIONS_FILE_PATH);
+        const SymbolIndex& symbols = GetSymbolIndex(options.jobs);
+
+        // Resolve every signature and group the work by component, keeping the
+        // order in which components first appear so the output matches a sequential run.
+        std::vector<std::string> componentOrder;
+        std::unordered_map<std::string, std::vector<FunctionInsertion>> insertionsByComponent;
+        std::unordered_map<std::string, std::string> componentByFunction;
+        // Already declared and defined in the requested component; only the stub
+        // flag and the CMakeLists entry are brought in line.
+        std::vector<ImplRequest> alreadyImplemented;
+
+        for (const auto& request : requests) {
+            auto existing = componentByFunction.find(request.functionName);
+            if (existing != componentByFunction.end()) {
+                if (existing->second != request.component) {
+                    std::cerr << "Error: function '" << request.functionName << "' requested for both '"
+                        << existing->second << "' and '" << request.component << "'" << std::endl;
+                    allSucceeded = false;
+                }
+                continue;
+            }
 
-        WriteSourceAndHeaderFiles(functionName, component);
+            try {
+                FunctionInsertion insertion{ FindFunctionSignature(index, request.functionName) };
+
+                std::string definedElsewhere;
+                std::string declaredElsewhere;
+                for (const auto& location : symbols.Find(request.functionName)) {
+                    if (location.component == request.component) {
+                        insertion.declare = !location.declared;
+                        insertion.define = !location.defined;
+                    } else if (location.defined) {
+                        definedElsewhere += (definedElsewhere.empty() ? "'" : ", '") + location.component + "'";
+                    } else {
+                        declaredElsewhere += (declaredElsewhere.empty() ? "'" : ", '") + location.component + "'";
+                    }
+                }
+                if (!definedElsewhere.empty()) {
+                    std::cerr << "Error: function '" << request.functionName << "' is already defined in component "
+                        << definedElsewhere << ", not adding it to '" << request.component << "'" << std::endl;
+                    allSucceeded = false;
+                    continue;
+                }
+                if (!declaredElsewhere.empty()) {
+                    std::cerr << "Warning: function '" << request.functionName << "' is also declared in component "
+                        << declaredElsewhere << std::endl;
+                }
 
-        std::cout << "Successfully implemented function '" << functionName
-            << "' in component '" << component << "'" << std::endl;
+                componentByFunction[request.functionName] = request.component;
+                if (!insertion.declare && !insertion.define) {
+                    std::cout << "Function '" << request.functionName << "' is already implemented in component '"
+                        << request.component << "'" << std::endl;
+                    alreadyImplemented.push_back(request);
+                    continue;
+                }
+                auto& insertions = insertionsByComponent[request.component];
+                if (insertions.empty()) componentOrder.push_back(request.component);
+                insertions.push_back(std::move(insertion));
+            }
+            catch (const std::runtime_error& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                allSucceeded = false;
+            }
+        }
+
+        // Per-component generation is independent, so it runs on the worker pool.
+        // Results land in slots indexed like componentOrder to keep the output deterministic.
+        struct ComponentResult {
+            ComponentFiles files;
+            std::string error;
+        };
+        std::vector<ComponentResult> results(componentOrder.size());
+        AddProgressTotal(componentOrder.size());
+        ParallelFor(componentOrder.size(), options.jobs, [&](size_t i) {
+            try {
+                ThrowIfCancelled();
+                results[i].files = LoadComponentFiles(componentOrder[i]);
+                const auto& insertions = insertionsByComponent.at(componentOrder[i]);
+                InsertFunctionsIntoComponent(results[i].files, insertions);
+                if (options.profile) {
+                    SetProfilingInSource(results[i].files.source, [&](std::string_view name) {
+                        return std::any_of(insertions.begin(), insertions.end(), [&](const FunctionInsertion& insertion) {
+                            return insertion.define && insertion.signature.name == name;
+                        });
+                    }, true);
+                }
+                AddProgressDone();
+            }
+            catch (const std::exception& e) {
+                results[i].error = e.what();
+            }
+        });
+        // Last point to stop: nothing has been written yet. From here on every
+        // file of the batch is written, so the workspace stays consistent.
+        ThrowIfCancelled();
+
+        // A component that could not be edited fails the whole batch, before anything is written.
+        bool editsFailed = false;
+        for (const auto& result : results) {
+            if (result.error.empty()) continue;
+            std::cerr << "Error: " << result.error << std::endl;
+            editsFailed = true;
+        }
+        if (editsFailed) {
+            std::cerr << "Nothing was written" << std::endl;
+            return false;
+        }
+
+        std::vector<ComponentFiles> componentFiles;
+        std::vector<std::string> implementedComponents;
+        for (size_t i = 0; i < componentOrder.size(); ++i) {
+            componentFiles.push_back(std::move(results[i].files));
+            implementedComponents.push_back(componentOrder[i]);
+        }
+
+        if (implementedComponents.empty() && alreadyImplemented.empty()) {
+            return false;
+        }
+
+        std::vector<const DefinitionEntry*> implementedEntries;
+        for (const auto& component : implementedComponents) {
+            for (const auto& insertion : insertionsByComponent[component]) {
+                implementedEntries.push_back(index.Find(insertion.signature.name));
+            }
+        }
+        for (const auto& request : alreadyImplemented) {
+            implementedEntries.push_back(index.Find(request.functionName));
+        }
+        std::string definitionsContent = index.Content();
+        bool definitionsChanged = SetFunctionStubsInContent(definitionsContent, implementedEntries, false);
+        // Rendered up front: it refuses duplicate or colliding names, which must
+        // fail the batch before any file is written.
+        DefinitionIndex updatedIndex;
+        std::optional<std::string> dispatchHeader;
+        if (definitionsChanged) {
+            updatedIndex.Build(std::move(definitionsContent));
+            dispatchHeader = RenderDispatchHeaderUpdate(updatedIndex);
+        }
+
+        bool hasCMakeLists = IsFileExists(CMAKELISTS_FILE_PATH);
+        std::string cmakeContent;
+        bool cmakeChanged = false;
+        UnityFileUpdates unityUpdates;
+        if (hasCMakeLists) {
+            cmakeContent = GetFileContent(CMAKELISTS_FILE_PATH);
+            for (const auto& component : implementedComponents) {
+                cmakeChanged |= AddSourceToCMakeListsContent(cmakeContent, component, unityUpdates);
+            }
+            for (const auto& request : alreadyImplemented) {
+                cmakeChanged |= AddSourceToCMakeListsContent(cmakeContent, request.component, unityUpdates);
+            }
+        } else {
+            std::cerr << "CMakeLists file does not exist: " << CMAKELISTS_FILE_PATH << std::endl;
+        }
+
+        // Component files are written by the workers. Definitions.cpp, CMakeLists.txt and
+        // the unity files are shared by components and are only ever written by this thread.
+        std::vector<std::string> saveErrors(componentFiles.size());
+        {
+            std::unique_ptr<ThreadPool> pool;
+            if (options.jobs > 1 && componentFiles.size() > 1) {
+                pool = std::make_unique<ThreadPool>(std::min<unsigned>(options.jobs, static_cast<unsigned>(componentFiles.size())));
+            }
+            for (size_t i = 0; i < componentFiles.size(); ++i) {
+                auto save = [&, i] {
+                    try {
+                        SaveComponentFiles(componentFiles[i]);
+                    }
+                    catch (const std::exception& e) {
+                        saveErrors[i] = e.what();
+                    }
+                };
+                if (pool) pool->Submit(save);
+                else save();
+            }
+
+            if (definitionsChanged) {
+                WriteToFile(DEFINITIONS_FILE_PATH, updatedIndex.Content());
+                UpdateDefinitionIndex(DEFINITIONS_FILE_PATH, updatedIndex);
+            }
+            for (const auto& [path, content] : unityUpdates) {
+                WriteToFile(path, content);
+            }
+            if (cmakeChanged) {
+                WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
+            }
+            if (options.profile && !componentFiles.empty() && WriteProfileHeader(index)) {
+                std::cout << "Wrote '" << PROFILE_HEADER_FILE_PATH << "'" << std::endl;
+            }
+            if (dispatchHeader) {
+                WriteToFile(DISPATCH_HEADER_FILE_PATH, *dispatchHeader);
+            }
+
+            if (pool) pool->Wait();
+        }
+        for (size_t i = 0; i < componentFiles.size(); ++i) {
+            if (!saveErrors[i].empty()) {
+                std::cerr << "Error: " << saveErrors[i] << std::endl;
+                allSucceeded = false;
+                continue;
+            }
+            UpdateComponentSymbols(componentFiles[i].component, componentFiles[i].header, componentFiles[i].source);
+        }
+
+        for (const auto& component : implementedComponents) {
+            for (const auto& insertion : insertionsByComponent[component]) {
+                std::cout << "Successfully implemented function '" << insertion.signature.name
+                    << "' in component '" << component << "'" << std::endl;
+            }
+        }
     }
     catch (const std::runtime_error& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        return false;
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        return false;
     }
     catch (...) {
-        std::cerr << "Unknown error implementing function '" << functionName << "'" << std::endl;
+        std::cerr << "Unknown error implementing functions" << std::endl;
+        return false;
     }
+    return allSucceeded;
+}
+
+bool implementFunction(const std::string& functionName, const std::string& component, const ImplOptions& options) {
+    return implementFunctions({ { functionName, component } }, options);
 }
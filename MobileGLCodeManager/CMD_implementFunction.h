@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+
+extern const char* GL_IMPL_DIRECTORY_PATH;
+extern const char* DEFINITIONS_FILE_PATH;
+extern const char* CMAKELISTS_FILE_PATH;
+// Workspace directory with templates overriding the generated boilerplate.
+extern const char* TEMPLATES_DIRECTORY_PATH;
+extern const char* DEFAULT_COMPONENT_INCLUDE;
+extern const char* INSERTION_POINT_INCLUDE;
+// Marks where GLImpl sources are listed in CMAKELISTS_FILE_PATH.
+extern const char* INSERTION_POINT_SOURCE_FILE_GLIMPL;
+
+struct ImplRequest {
+    std::string functionName;
+    std::string component;
+};
+
+struct FunctionSignature {
+    std::string returnType;
+    std::string name;
+    std::string params;
+    std::string args; // parameter names, comma separated
+};
+
+// The parts of a function that still have to be added to a component.
+struct FunctionInsertion {
+    FunctionSignature signature;
+    bool declare = true; // into GL_<component>.h
+    bool define = true;  // into GL_<component>.cpp
+};
+
+struct ComponentFiles {
+    std::string component;
+    std::string filePathPrefix;
+    std::string header;
+    std::string source;
+};
+
+struct ImplOptions {
+    // Worker threads for per-component header/source generation; 1 runs sequentially.
+    unsigned jobs = 1;
+    // Start every generated function with the MG_PROFILE_GL_FUNCTION prologue (see CMD_profile.h).
+    bool profile = false;
+};
+
+// Session defaults, adjusted by command-line options.
+ImplOptions& DefaultImplOptions();
+
+// Single-function, file-level building blocks of implementFunction.
+void SetFunctionStub(const std::string& filename, const std::string& func_name, bool is_stub);
+void MakeSureSourceInCMakeListsFile(const std::string& component);
+// Lists 'sourcePath' right below the GLImpl insertion point of the CMakeLists
+// content, unless it is already listed. Returns true if the content changed.
+bool AddGLImplSourceToCMakeListsContent(std::string& cmakeContent, const std::string& sourcePath);
+void WriteSourceAndHeaderFiles(const std::string& functionName, const std::string& component);
+
+// Sets the #include lines right below the INCLUDE insertion point of a component
+// header to 'headers', plus the ones already there if 'merge', sorted. Returns
+// true if the header changed; false also if it has no such insertion point.
+bool SetComponentIncludes(std::string& header, std::vector<std::string> headers, bool merge);
+
+// Reads a manifest of "<function_name> <component>" lines ('#' starts a comment).
+std::vector<ImplRequest> ReadImplManifest(const std::string& filename);
+
+// Implements every requested function in one pass: each touched file is read once
+// and written at most once. Functions a component already declares and defines
+// are left alone, and a function defined by another component is refused before
+// any file is touched. Returns false if any request failed.
+bool implementFunctions(const std::vector<ImplRequest>& requests, const ImplOptions& options = DefaultImplOptions());
+bool implementFunction(const std::string& functionName, const std::string& component, const ImplOptions& options = DefaultImplOptions());
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "CMD_implementFunction.h"
+#include "Commands.h"
+#include "ComponentScanner.h"
+#include "DefinitionIndex.h"
+#include "DefinitionScanner.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+#include "Progress.h"
+#include "SymbolIndex.h"
+#include "TypeHeaders.h"
+
+const char* PCH_FILE_PATH = "MobileGL/MG_Impl/GLImpl/GLImplPCH.h";
+
+// Headers needed by every function a component header declares. Signatures come
+// from the definitions where possible, so they match what impl would generate.
+static std::vector<std::string> ComponentHeadersFor(const TypeHeaderMap& map, const DefinitionIndex* index, std::string_view header) {
+    std::vector<std::string> headers;
+    for (const auto& symbol : ScanComponentDeclarations(header)) {
+        const DefinitionEntry* entry = index ? index->Find(symbol.name) : nullptr;
+        auto needed = entry ? map.HeadersFor(entry->returnType, entry->params)
+                            : map.HeadersFor(symbol.returnType, SplitMacroArguments(symbol.params));
+        headers.insert(headers.end(), needed.begin(), needed.end());
+    }
+    return headers;
+}
+
+int CMD_includes(const std::vector<std::string>& args) {
+    if (args.size() >= 2 && args[1].starts_with("-")) {
+        std::cout << "Usage: includes [<component>...]" << std::endl;
+        std::cout << "Replaces '" << DEFAULT_COMPONENT_INCLUDE << "' in component headers (default: all) with the" << std::endl;
+        std::cout << "headers their declarations need, as listed in '" << TYPE_HEADERS_FILE_PATH << "'," << std::endl;
+        std::cout << "and drops includes no declaration needs any more." << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+
+    bool allSucceeded = true;
+    try {
+        auto map = LoadTypeHeaderMap();
+        if (!map) {
+            std::cerr << "Type map does not exist '" << TYPE_HEADERS_FILE_PATH << "'" << std::endl;
+            return COMMAND_FAILED;
+        }
+        const DefinitionIndex* index = IsFileExists(DEFINITIONS_FILE_PATH) ? &GetDefinitionIndex(DEFINITIONS_FILE_PATH) : nullptr;
+
+        std::vector<std::string> components(args.begin() + 1, args.end());
+        if (components.empty()) components = ListComponents();
+
+        size_t updated = 0;
+        AddProgressTotal(components.size());
+        for (const auto& component : components) {
+            // Each component is written on its own, so stopping between two is safe.
+            ThrowIfCancelled();
+            AddProgressDone();
+            std::string headerPath = ComponentHeaderPath(component);
+            if (!IsFileExists(headerPath)) {
+                std::cerr << "Error: component header does not exist '" << headerPath << "'" << std::endl;
+                allSucceeded = false;
+                continue;
+            }
+            std::string header = GetFileContent(headerPath);
+
+            bool converted = false;
+            if (header.find(INSERTION_POINT_INCLUDE) == std::string::npos) {
+                size_t include = header.find(DEFAULT_COMPONENT_INCLUDE);
+                if (include == std::string::npos) {
+                    std::cerr << "Warning: neither '" << DEFAULT_COMPONENT_INCLUDE << "' nor '" << INSERTION_POINT_INCLUDE
+                        << "' in '" << headerPath << "', skipped" << std::endl;
+                    continue;
+                }
+                header.replace(include, strlen(DEFAULT_COMPONENT_INCLUDE), INSERTION_POINT_INCLUDE);
+                converted = true;
+            }
+            std::vector<std::string> headers = ComponentHeadersFor(*map, index, header);
+            if (!SetComponentIncludes(header, headers, false) && !converted) continue;
+
+            WriteToFile(headerPath, header);
+            std::string sourcePath = ComponentSourcePath(component);
+            UpdateComponentSymbols(component, header, IsFileExists(sourcePath) ? GetFileContent(sourcePath) : std::string());
+
+            std::sort(headers.begin(), headers.end());
+            headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+            std::cout << "Updated includes of component '" << component << "':";
+            for (const auto& include : headers) std::cout << " " << include;
+            std::cout << std::endl;
+            ++updated;
+        }
+        if (updated == 0) std::cout << "Includes are up to date" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return allSucceeded ? COMMAND_OK : COMMAND_FAILED;
+}
+
+// The target whose source list holds the GLImpl insertion point, and the offset
+// just past the closing parenthesis of its add_library/add_executable call.
+static bool FindGLImplTarget(const std::string& cmakeContent, std::string& target, size_t& callEnd) {
+    size_t marker = cmakeContent.find(INSERTION_POINT_SOURCE_FILE_GLIMPL);
+    if (marker == std::string::npos) return false;
+
+    size_t call = std::string::npos;
+    for (const char* command : { "add_library(", "add_executable(" }) {
+        size_t found = cmakeContent.rfind(command, marker);
+        if (found != std::string::npos && (call == std::string::npos || found > call)) call = found;
+    }
+    if (call == std::string::npos) return false;
+
+    size_t open = cmakeContent.find('(', call);
+    size_t nameBegin = cmakeContent.find_first_not_of(" \t\r\n", open + 1);
+    size_t nameEnd = cmakeContent.find_first_of(" \t\r\n)", nameBegin);
+    if (nameBegin == std::string::npos || nameEnd == std::string::npos) return false;
+    target = cmakeContent.substr(nameBegin, nameEnd - nameBegin);
+
+    int depth = 0;
+    for (size_t i = open; i < cmakeContent.size(); ++i) {
+        char c = cmakeContent[i];
+        if (c == '#') {
+            i = cmakeContent.find('\n', i);
+            if (i == std::string::npos) return false;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')' && --depth == 0) {
+            callEnd = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+int CMD_pch(const std::vector<std::string>& args) {
+    if (args.size() != 2 || (args[1] != "on" && args[1] != "off")) {
+        std::cout << "Usage: pch on|off" << std::endl;
+        std::cout << "'on' writes '" << PCH_FILE_PATH << "' with the headers GLImpl functions need" << std::endl;
+        std::cout << "(see 'includes') and adds it to the GLImpl target in '" << CMAKELISTS_FILE_PATH << "'" << std::endl;
+        std::cout << "with target_precompile_headers. 'off' removes it from the target again." << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+    bool enable = args[1] == "on";
+
+    if (!IsFileExists(CMAKELISTS_FILE_PATH)) {
+        std::cerr << "CMakeLists file does not exist: " << CMAKELISTS_FILE_PATH << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    try {
+        std::string cmakeContent = GetFileContent(CMAKELISTS_FILE_PATH);
+        std::string target;
+        size_t callEnd = 0;
+        if (!FindGLImplTarget(cmakeContent, target, callEnd)) {
+            std::cerr << "Error: no add_library or add_executable holding '" << INSERTION_POINT_SOURCE_FILE_GLIMPL
+                << "' in '" << CMAKELISTS_FILE_PATH << "'" << std::endl;
+            return COMMAND_FAILED;
+        }
+        std::string newline(DetectNewline(cmakeContent));
+        std::string line = "target_precompile_headers(" + target + " PRIVATE " + PCH_FILE_PATH + ")";
+        size_t existing = cmakeContent.find(line);
+
+        if (!enable) {
+            if (existing == std::string::npos) {
+                std::cout << "No precompiled header in '" << CMAKELISTS_FILE_PATH << "'" << std::endl;
+                return COMMAND_OK;
+            }
+            size_t eraseFrom = existing >= newline.size() && cmakeContent.compare(existing - newline.size(), newline.size(), newline) == 0
+                ? existing - newline.size() : existing;
+            cmakeContent.erase(eraseFrom, existing + line.size() - eraseFrom);
+            WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
+            std::cout << "Removed precompiled header from target '" << target << "'" << std::endl;
+            return COMMAND_OK;
+        }
+
+        std::vector<std::string> headers;
+        if (auto map = LoadTypeHeaderMap()) {
+            if (IsFileExists(DEFINITIONS_FILE_PATH)) {
+                for (const auto& entry : GetDefinitionIndex(DEFINITIONS_FILE_PATH).Entries()) {
+                    auto needed = map->HeadersFor(entry.returnType, entry.params);
+                    headers.insert(headers.end(), needed.begin(), needed.end());
+                }
+            }
+            std::sort(headers.begin(), headers.end());
+            headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+        } else {
+            headers.push_back(std::string(DEFAULT_COMPONENT_INCLUDE).substr(strlen("#include ")));
+        }
+
+        std::string pch = "// Generated by MobileGLCodeManager ('pch'). Do not edit." + newline + "#pragma once" + newline;
+        for (const auto& include : headers) pch += "#include " + include + newline;
+        if (WriteToFile(PCH_FILE_PATH, pch)) {
+            std::cout << "Wrote '" << PCH_FILE_PATH << "' (" << headers.size() << " headers)" << std::endl;
+        }
+        if (existing == std::string::npos) {
+            cmakeContent.insert(callEnd, newline + line);
+            WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
+            std::cout << "Added precompiled header to target '" << target << "'" << std::endl;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
@@ -0,0 +1,297 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <unordered_set>
+#include <stdexcept>
+
+#include "CMD_profile.h"
+#include "CMD_implementFunction.h"
+#include "Commands.h"
+#include "ComponentScanner.h"
+#include "DefinitionIndex.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+#include "Progress.h"
+#include "SymbolIndex.h"
+
+const char* PROFILE_HEADER_FILE_PATH = "MobileGL/MG_Impl/GLImpl/Exporting/GLProfile.h";
+const char* PROFILE_HEADER_INCLUDE = "#include \"../Exporting/GLProfile.h\"";
+
+static constexpr std::string_view PROFILE_MACRO = "MG_PROFILE_GL_FUNCTION(";
+
+static const char* GENERATED_PROFILE_RUNTIME = R"gen(
+    // One table per thread, written only by its owner; Dump reads them with relaxed
+    // loads, so neither side ever waits. Tables are never freed, so calls made on
+    // threads that have exited still show up in Dump.
+    struct ThreadTable {
+        std::atomic<std::uint64_t> calls[FunctionCount];
+        std::atomic<std::uint64_t> nanoseconds[FunctionCount];
+        ThreadTable* next = nullptr;
+    };
+
+    inline std::atomic<ThreadTable*> threadTables{ nullptr };
+
+    inline ThreadTable& LocalTable() {
+        thread_local ThreadTable* table = [] {
+            ThreadTable* created = new ThreadTable();
+            created->next = threadTables.load(std::memory_order_relaxed);
+            while (!threadTables.compare_exchange_weak(created->next, created, std::memory_order_release, std::memory_order_relaxed)) {}
+            return created;
+        }();
+        return *table;
+    }
+
+    class Scope {
+    public:
+        explicit Scope(Id id) : id(static_cast<std::size_t>(id)), start(std::chrono::steady_clock::now()) {}
+        ~Scope() {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            ThreadTable& table = LocalTable();
+            table.calls[id].store(table.calls[id].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            table.nanoseconds[id].store(table.nanoseconds[id].load(std::memory_order_relaxed) + static_cast<std::uint64_t>(elapsed), std::memory_order_relaxed);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::size_t id;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // Prints every function called so far, summed over all threads, slowest first.
+    inline void Dump(std::FILE* out = stderr) {
+        struct Total {
+            std::size_t id;
+            std::uint64_t calls;
+            std::uint64_t nanoseconds;
+        };
+        std::vector<Total> totals;
+        for (std::size_t id = 0; id < FunctionCount; ++id) totals.push_back({ id, 0, 0 });
+        for (ThreadTable* table = threadTables.load(std::memory_order_acquire); table; table = table->next) {
+            for (std::size_t id = 0; id < FunctionCount; ++id) {
+                totals[id].calls += table->calls[id].load(std::memory_order_relaxed);
+                totals[id].nanoseconds += table->nanoseconds[id].load(std::memory_order_relaxed);
+            }
+        }
+        std::stable_sort(totals.begin(), totals.end(), [](const Total& a, const Total& b) { return a.nanoseconds > b.nanoseconds; });
+
+        std::fprintf(out, "%-48s %12s %14s %12s\n", "function", "calls", "total ms", "avg us");
+        for (const Total& total : totals) {
+            if (total.calls == 0) continue;
+            std::fprintf(out, "%-48s %12llu %14.3f %12.3f\n", Names[total.id], static_cast<unsigned long long>(total.calls),
+                total.nanoseconds / 1e6, total.nanoseconds / 1e3 / total.calls);
+        }
+    }
+)gen";
+
+std::string GenerateProfileHeader(const DefinitionIndex& index) {
+    ScopedTimer timer("GenerateProfileHeader");
+
+    const auto& entries = index.Entries();
+    if (entries.empty()) {
+        throw std::runtime_error("No functions in definitions file '" + std::string(DEFINITIONS_FILE_PATH) + "'");
+    }
+
+    // Definitions.cpp may list a function twice ('verify' reports it); the header
+    // has one enumerator per name, or it would not compile.
+    std::vector<std::string_view> names;
+    std::unordered_set<std::string_view> seen;
+    for (const auto& entry : entries) {
+        if (seen.insert(entry.name).second) names.push_back(entry.name);
+    }
+
+    std::string out;
+    out.reserve(names.size() * 64 + 4096);
+    out += "// Generated by MobileGLCodeManager ('profile') from Definitions.cpp. Do not edit.\n"
+        "#pragma once\n"
+        "\n"
+        "// Instrumented GL functions start with MG_PROFILE_GL_FUNCTION(name). Unless\n"
+        "// MOBILEGL_PROFILE_GL is defined it expands to ((void)0), and this header\n"
+        "// declares nothing else.\n"
+        "#ifndef MOBILEGL_PROFILE_GL\n"
+        "#define MG_PROFILE_GL_FUNCTION(name) ((void)0)\n"
+        "#else\n"
+        "#include <algorithm>\n"
+        "#include <atomic>\n"
+        "#include <chrono>\n"
+        "#include <cstddef>\n"
+        "#include <cstdint>\n"
+        "#include <cstdio>\n"
+        "#include <vector>\n"
+        "\n"
+        "namespace MobileGL::GLProfile {\n"
+        "    enum class Id : std::uint32_t {\n";
+    for (auto name : names) {
+        out += "        ";
+        out += name;
+        out += ",\n";
+    }
+    out += "    };\n\n";
+    out += "    inline constexpr std::size_t FunctionCount = " + std::to_string(names.size()) + ";\n\n";
+    out += "    inline constexpr const char* Names[FunctionCount] = {\n";
+    for (auto name : names) {
+        out += "        \"";
+        out += name;
+        out += "\",\n";
+    }
+    out += "    };\n";
+    out += GENERATED_PROFILE_RUNTIME;
+    out += "} // namespace MobileGL::GLProfile\n"
+        "\n"
+        "#define MG_PROFILE_GL_FUNCTION(name) ::MobileGL::GLProfile::Scope mgProfileScope(::MobileGL::GLProfile::Id::name)\n"
+        "#endif\n";
+    return out;
+}
+
+bool WriteProfileHeader(const DefinitionIndex& index) {
+    return WriteToFile(PROFILE_HEADER_FILE_PATH, GenerateProfileHeader(index));
+}
+
+static std::string_view LeadingWhitespace(std::string_view text, size_t lineStart) {
+    size_t end = text.find_first_not_of(" \t", lineStart);
+    if (end == std::string_view::npos) end = text.size();
+    return text.substr(lineStart, end - lineStart);
+}
+
+size_t SetProfilingInSource(std::string& source, const std::function<bool(std::string_view name)>& select, bool enable) {
+    ScopedTimer timer("SetProfilingInSource");
+
+    std::string newline(DetectNewline(source));
+
+    // Body openings of the selected functions, found before anything is edited.
+    struct Target {
+        std::string name;
+        size_t lineStart = 0;
+        size_t brace = 0;
+    };
+    std::vector<Target> targets;
+    for (const auto& symbol : ScanComponentDefinitions(source)) {
+        if (!select(symbol.name)) continue;
+        size_t paramsEnd = static_cast<size_t>(symbol.params.data() - source.data()) + symbol.params.size();
+        size_t brace = source.find('{', paramsEnd);
+        if (brace == std::string::npos) continue;
+        size_t lineStart = source.rfind('\n', static_cast<size_t>(symbol.name.data() - source.data()));
+        targets.push_back({ std::string(symbol.name), lineStart == std::string::npos ? 0 : lineStart + 1, brace });
+    }
+
+    // Back to front, so the offsets of the remaining targets stay valid.
+    size_t changed = 0;
+    for (auto it = targets.rbegin(); it != targets.rend(); ++it) {
+        size_t bodyStart = it->brace + 1;
+        size_t firstToken = source.find_first_not_of(" \t\r\n", bodyStart);
+        if (firstToken == std::string::npos) continue;
+        bool instrumented = std::string_view(source).substr(firstToken).starts_with(PROFILE_MACRO);
+        if (instrumented == enable) continue;
+
+        if (!enable) {
+            size_t semicolon = source.find(';', firstToken);
+            if (semicolon == std::string::npos) continue;
+            source.erase(bodyStart, semicolon + 1 - bodyStart);
+            // "{ MG_PROFILE_GL_FUNCTION(name); }" was "{}".
+            if (source.compare(bodyStart, 2, " }") == 0) source.erase(bodyStart, 1);
+            ++changed;
+            continue;
+        }
+
+        std::string prologue;
+        if (source.find('\n', bodyStart) < firstToken) {
+            std::string bodyIndent;
+            if (source[firstToken] == '}') bodyIndent = std::string(LeadingWhitespace(source, it->lineStart)) + "    ";
+            else bodyIndent = LeadingWhitespace(source, source.rfind('\n', firstToken) + 1);
+            prologue = newline + bodyIndent;
+        } else {
+            // A body on the definition line, e.g. "{ return x; }", stays on one line.
+            prologue = " ";
+        }
+        prologue += PROFILE_MACRO;
+        prologue += it->name + ");";
+        if (firstToken == bodyStart) prologue += " ";
+        source.insert(bodyStart, prologue);
+        ++changed;
+    }
+
+    size_t include = source.find(PROFILE_HEADER_INCLUDE);
+    if (enable && changed > 0 && include == std::string::npos) {
+        // Below the first include, normally the component's own header.
+        size_t firstInclude = source.starts_with("#include") ? 0 : source.find("\n#include");
+        if (firstInclude == std::string::npos) {
+            source.insert(0, PROFILE_HEADER_INCLUDE + newline);
+        } else {
+            size_t lineEnd = source.find('\n', firstInclude + 1);
+            if (lineEnd == std::string::npos) lineEnd = source.size();
+            else if (lineEnd > 0 && source[lineEnd - 1] == '\r') --lineEnd;
+            source.insert(lineEnd, newline + PROFILE_HEADER_INCLUDE);
+        }
+    } else if (!enable && include != std::string::npos && source.find(PROFILE_MACRO) == std::string::npos) {
+        size_t lineEnd = include + std::string_view(PROFILE_HEADER_INCLUDE).size();
+        if (include >= newline.size() && source.compare(include - newline.size(), newline.size(), newline) == 0) {
+            source.erase(include - newline.size(), lineEnd - include + newline.size());
+        } else {
+            source.erase(include, source.compare(lineEnd, newline.size(), newline) == 0 ? lineEnd - include + newline.size() : lineEnd - include);
+        }
+    }
+    return changed;
+}
+
+int CMD_profile(const std::vector<std::string>& args) {
+    if (args.size() < 2 || (args[1] != "on" && args[1] != "off")) {
+        std::cout << "Usage: profile on|off [<component>...]" << std::endl;
+        std::cout << "Adds or removes a MG_PROFILE_GL_FUNCTION prologue in every GL function of the" << std::endl;
+        std::cout << "given components (default: all) and writes '" << PROFILE_HEADER_FILE_PATH << "'." << std::endl;
+        std::cout << "Build with MOBILEGL_PROFILE_GL defined to count and time calls, and call" << std::endl;
+        std::cout << "MobileGL::GLProfile::Dump() to print them; otherwise the prologue compiles to nothing." << std::endl;
+        std::cout << "'impl -p' instruments newly generated functions." << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+    bool enable = args[1] == "on";
+
+    if (!IsFileExists(DEFINITIONS_FILE_PATH)) {
+        std::cerr << "Definitions file does not exist '" << DEFINITIONS_FILE_PATH << "'" << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    bool allSucceeded = true;
+    try {
+        const DefinitionIndex& index = GetDefinitionIndex(DEFINITIONS_FILE_PATH);
+        if (enable && WriteProfileHeader(index)) {
+            std::cout << "Wrote '" << PROFILE_HEADER_FILE_PATH << "'" << std::endl;
+        }
+
+        std::vector<std::string> components(args.begin() + 2, args.end());
+        if (components.empty()) components = ListComponents();
+
+        auto isGLFunction = [&](std::string_view name) { return index.Find(name) != nullptr; };
+        size_t total = 0;
+        AddProgressTotal(components.size());
+        for (const auto& component : components) {
+            ThrowIfCancelled();
+            AddProgressDone();
+            std::string sourcePath = ComponentSourcePath(component);
+            if (!IsFileExists(sourcePath)) {
+                std::cerr << "Error: component source does not exist '" << sourcePath << "'" << std::endl;
+                allSucceeded = false;
+                continue;
+            }
+            std::string source = GetFileContent(sourcePath);
+            size_t changed = SetProfilingInSource(source, isGLFunction, enable);
+            if (changed == 0) continue;
+
+            WriteToFile(sourcePath, source);
+            std::string headerPath = ComponentHeaderPath(component);
+            UpdateComponentSymbols(component, IsFileExists(headerPath) ? GetFileContent(headerPath) : std::string(), source);
+            std::cout << (enable ? "Instrumented " : "Removed profiling from ") << changed
+                << " function(s) in component '" << component << "'" << std::endl;
+            total += changed;
+        }
+        if (total == 0) {
+            std::cout << "No functions to " << (enable ? "instrument" : "change") << std::endl;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return allSucceeded ? COMMAND_OK : COMMAND_FAILED;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <functional>
+
+class DefinitionIndex;
+
+// Default location of the generated GL profiling header.
+extern const char* PROFILE_HEADER_FILE_PATH;
+// How component sources include it, relative to GL_IMPL_DIRECTORY_PATH/<component>/.
+extern const char* PROFILE_HEADER_INCLUDE;
+
+// Renders the profiling header for every function in the index. Unless
+// MOBILEGL_PROFILE_GL is defined, MG_PROFILE_GL_FUNCTION(name) expands to
+// nothing and the header declares nothing else. With it defined, each call is
+// counted and timed into a per-thread table, and MobileGL::GLProfile::Dump
+// prints the totals over all threads.
+std::string GenerateProfileHeader(const DefinitionIndex& index);
+
+// Writes PROFILE_HEADER_FILE_PATH. Returns true if it changed.
+bool WriteProfileHeader(const DefinitionIndex& index);
+
+// Adds (enable) or removes the MG_PROFILE_GL_FUNCTION prologue of every
+// function defined in 'source' that 'select' accepts, along with the include
+// of the profiling header. Functions that already are in the requested state
+// are left alone. Returns the number of functions changed.
+size_t SetProfilingInSource(std::string& source, const std::function<bool(std::string_view name)>& select, bool enable);
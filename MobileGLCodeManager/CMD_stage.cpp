@@ -0,0 +1,224 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "Commands.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+
+enum class DiffOp { Equal, Delete, Insert };
+
+struct DiffLine {
+    DiffOp op;
+    std::string_view text;
+};
+
+static std::vector<std::string_view> SplitLines(std::string_view content) {
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < content.size()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string_view::npos) end = content.size();
+        lines.push_back(content.substr(start, end - start));
+        start = end + 1;
+    }
+    return lines;
+}
+
+// Beyond this edit distance the diff degrades to "remove everything, add everything",
+// which keeps the Myers trace small for rewritten files.
+static constexpr int MAX_DIFF_EDITS = 2000;
+
+// Myers' O(ND) line diff, run on the part between the common prefix and suffix.
+static std::vector<DiffLine> DiffLines(const std::vector<std::string_view>& a, const std::vector<std::string_view>& b) {
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) ++prefix;
+    size_t suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+           a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix]) ++suffix;
+
+    const int n = static_cast<int>(a.size() - prefix - suffix);
+    const int m = static_cast<int>(b.size() - prefix - suffix);
+    auto A = [&](int i) { return a[prefix + i]; };
+    auto B = [&](int i) { return b[prefix + i]; };
+
+    std::vector<DiffLine> middle;
+    const int maxEdits = std::min(n + m, MAX_DIFF_EDITS);
+    const int offset = maxEdits + 1;
+    std::vector<int> v(2 * offset + 1, 0);
+    std::vector<std::vector<int>> trace;
+    int edits = -1;
+    for (int d = 0; d <= maxEdits && edits < 0; ++d) {
+        trace.push_back(v);
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                ? v[offset + k + 1] : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && A(x) == B(y)) { ++x; ++y; }
+            v[offset + k] = x;
+            if (x >= n && y >= m) { edits = d; break; }
+        }
+    }
+
+    if (edits < 0) {
+        for (int i = 0; i < n; ++i) middle.push_back({ DiffOp::Delete, A(i) });
+        for (int j = 0; j < m; ++j) middle.push_back({ DiffOp::Insert, B(j) });
+    } else {
+        int x = n, y = m;
+        for (int d = edits; d > 0; --d) {
+            const auto& prev = trace[d];
+            int k = x - y;
+            int prevK = (k == -d || (k != d && prev[offset + k - 1] < prev[offset + k + 1])) ? k + 1 : k - 1;
+            int prevX = prev[offset + prevK];
+            int prevY = prevX - prevK;
+            while (x > prevX && y > prevY) { middle.push_back({ DiffOp::Equal, A(--x) }); --y; }
+            if (x == prevX) middle.push_back({ DiffOp::Insert, B(--y) });
+            else middle.push_back({ DiffOp::Delete, A(--x) });
+        }
+        while (x > 0 && y > 0) { middle.push_back({ DiffOp::Equal, A(--x) }); --y; }
+        std::reverse(middle.begin(), middle.end());
+    }
+
+    std::vector<DiffLine> result;
+    result.reserve(prefix + middle.size() + suffix);
+    for (size_t i = 0; i < prefix; ++i) result.push_back({ DiffOp::Equal, a[i] });
+    result.insert(result.end(), middle.begin(), middle.end());
+    for (size_t i = a.size() - suffix; i < a.size(); ++i) result.push_back({ DiffOp::Equal, a[i] });
+    return result;
+}
+
+static std::string_view StripCarriageReturn(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// Prints a unified diff with three lines of context.
+static void PrintUnifiedDiff(const std::string& path, bool isNew, std::string_view before, std::string_view after) {
+    constexpr size_t CONTEXT = 3;
+    std::vector<DiffLine> lines = DiffLines(SplitLines(before), SplitLines(after));
+
+    std::cout << "--- " << (isNew ? "/dev/null" : "a/" + path) << std::endl;
+    std::cout << "+++ b/" << path << std::endl;
+
+    size_t i = 0;
+    while (i < lines.size()) {
+        while (i < lines.size() && lines[i].op == DiffOp::Equal) ++i;
+        if (i == lines.size()) break;
+
+        // Extend the hunk while the gap between changes fits in two contexts.
+        size_t start = i >= CONTEXT ? i - CONTEXT : 0;
+        size_t end = i;
+        while (end < lines.size()) {
+            size_t gap = end;
+            while (gap < lines.size() && lines[gap].op == DiffOp::Equal) ++gap;
+            if (gap == lines.size() || gap - end > 2 * CONTEXT) {
+                end = std::min(end + CONTEXT, gap);
+                break;
+            }
+            end = gap;
+            while (end < lines.size() && lines[end].op != DiffOp::Equal) ++end;
+        }
+
+        size_t oldLine = 1, newLine = 1;
+        for (size_t j = 0; j < start; ++j) {
+            if (lines[j].op != DiffOp::Insert) ++oldLine;
+            if (lines[j].op != DiffOp::Delete) ++newLine;
+        }
+        size_t oldCount = 0, newCount = 0;
+        for (size_t j = start; j < end; ++j) {
+            if (lines[j].op != DiffOp::Insert) ++oldCount;
+            if (lines[j].op != DiffOp::Delete) ++newCount;
+        }
+        std::cout << "@@ -" << (oldCount ? oldLine : oldLine - 1) << "," << oldCount
+            << " +" << (newCount ? newLine : newLine - 1) << "," << newCount << " @@" << std::endl;
+        for (size_t j = start; j < end; ++j) {
+            char marker = lines[j].op == DiffOp::Equal ? ' ' : lines[j].op == DiffOp::Delete ? '-' : '+';
+            std::cout << marker << StripCarriageReturn(lines[j].text) << std::endl;
+        }
+        i = end;
+    }
+}
+
+int CMD_stage(const std::vector<std::string>& args) {
+    if (args.size() == 1) {
+        std::cout << "Staging is " << (IsStagingEnabled() ? "on" : "off") << ", "
+            << GetStagedFiles().size() << " file(s) staged" << std::endl;
+        return COMMAND_OK;
+    }
+    if (args.size() == 2 && args[1] == "on") {
+        SetStagingEnabled(true);
+        std::cout << "Staging enabled; edits stay in memory until 'commit'" << std::endl;
+        return COMMAND_OK;
+    }
+    if (args.size() == 2 && args[1] == "off") {
+        if (HasStagedFiles()) {
+            std::cerr << "There are staged changes; run 'commit' or 'discard' first" << std::endl;
+            return COMMAND_FAILED;
+        }
+        SetStagingEnabled(false);
+        std::cout << "Staging disabled" << std::endl;
+        return COMMAND_OK;
+    }
+    std::cout << "Usage: stage [on|off]" << std::endl;
+    return COMMAND_USAGE_ERROR;
+}
+
+int CMD_diff(const std::vector<std::string>& args) {
+    ScopedTimer timer("Diff");
+    std::vector<StagedFile> files = GetStagedFiles();
+    if (files.empty()) {
+        std::cout << "No staged changes" << std::endl;
+        return COMMAND_OK;
+    }
+
+    bool statOnly = args.size() == 2 && args[1] == "--stat";
+    if (args.size() > 1 && !statOnly) {
+        std::cout << "Usage: diff [--stat]" << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+
+    try {
+        for (const auto& file : files) {
+            // The staged entry shadows the file, so read the original from disk directly.
+            bool isNew = !std::filesystem::exists(file.path);
+            std::string original;
+            if (!isNew) original = ReadFileFromDisk(file.path);
+            if (statOnly) {
+                std::cout << (isNew ? "  new       " : "  modified  ") << file.path << std::endl;
+            } else {
+                PrintUnifiedDiff(file.path, isNew, original, file.content);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
+
+int CMD_commit(const std::vector<std::string>& args) {
+    size_t staged = GetStagedFiles().size();
+    if (staged == 0) {
+        std::cout << "No staged changes" << std::endl;
+        return COMMAND_OK;
+    }
+    try {
+        size_t written = CommitStagedFiles();
+        std::cout << "Committed " << staged << " staged file(s), " << written << " written" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
+
+int CMD_discard(const std::vector<std::string>& args) {
+    size_t discarded = DiscardStagedFiles();
+    std::cout << "Discarded " << discarded << " staged file(s)" << std::endl;
+    return COMMAND_OK;
+}
@@ -0,0 +1,274 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+
+#include "CMD_unity.h"
+#include "CMD_implementFunction.h"
+#include "Commands.h"
+#include "ComponentScanner.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+#include "SymbolIndex.h"
+
+const char* UNITY_DIRECTORY_PATH = "MobileGL/MG_Impl/GLImpl/Unity";
+
+static const char* UNITY_FILE_PREFIX = "GLImpl_Unity";
+static const char* UNITY_FILE_HEADER =
+    "// Generated by MobileGLCodeManager ('unity'). New components are appended to\n"
+    "// the file with the fewest functions; 'unity <count>' changes the file count.\n";
+
+std::string UnityFilePath(size_t k) {
+    return std::string(UNITY_DIRECTORY_PATH) + "/" + UNITY_FILE_PREFIX + std::to_string(k) + ".cpp";
+}
+
+bool IsUnityBuildActive(const std::string& cmakeContent) {
+    return cmakeContent.find(std::string(UNITY_DIRECTORY_PATH) + "/" + UNITY_FILE_PREFIX) != std::string::npos;
+}
+
+static std::string UnityInclude(const std::string& component) {
+    return "#include \"../" + component + "/GL_" + component + ".cpp\"";
+}
+
+// Unity files with pending updates are read from 'updates' instead of the disk.
+static std::vector<std::vector<std::string>> LoadUnityGroups(const std::string& cmakeContent, const UnityFileUpdates& updates) {
+    std::vector<std::vector<std::string>> groups;
+    for (size_t k = 0; cmakeContent.find(UnityFilePath(k)) != std::string::npos; ++k) {
+        std::string content;
+        if (auto pending = updates.find(UnityFilePath(k)); pending != updates.end()) {
+            content = pending->second;
+        } else if (IsFileExists(UnityFilePath(k))) {
+            content = GetFileContent(UnityFilePath(k));
+        } else {
+            throw std::runtime_error("CMakeLists lists unity file '" + UnityFilePath(k) + "', which does not exist");
+        }
+        auto& group = groups.emplace_back();
+        size_t pos = 0;
+        while ((pos = content.find("#include \"../", pos)) != std::string::npos) {
+            size_t begin = pos + strlen("#include \"../");
+            size_t end = content.find('/', begin);
+            if (end == std::string::npos) break;
+            group.push_back(content.substr(begin, end - begin));
+            pos = end;
+        }
+    }
+    return groups;
+}
+
+std::vector<std::vector<std::string>> LoadUnityGroups(const std::string& cmakeContent) {
+    return LoadUnityGroups(cmakeContent, UnityFileUpdates());
+}
+
+static std::string RenderUnityFile(const std::vector<std::string>& group) {
+    std::string content = UNITY_FILE_HEADER;
+    for (const auto& component : group) content += UnityInclude(component) + "\n";
+    return content;
+}
+
+static size_t FunctionCount(const SymbolIndex& symbols, const std::string& component) {
+    const ComponentSymbolSet* set = symbols.Symbols(component);
+    return set ? set->defined.size() : 0;
+}
+
+std::vector<std::vector<std::string>> BalanceUnityGroups(const std::vector<std::vector<std::string>>& previous,
+    const std::vector<std::string>& components, const std::vector<size_t>& weights, size_t count) {
+    std::unordered_map<std::string, size_t> weightOf;
+    for (size_t i = 0; i < components.size(); ++i) weightOf[components[i]] = weights[i];
+
+    std::vector<std::vector<std::string>> groups(count);
+    std::vector<size_t> load(count, 0);
+    std::unordered_map<std::string, bool> placed;
+    for (size_t k = 0; k < std::min(count, previous.size()); ++k) {
+        for (const auto& component : previous[k]) {
+            auto weight = weightOf.find(component);
+            if (weight == weightOf.end() || placed[component]) continue; // gone, or listed twice
+            groups[k].push_back(component);
+            load[k] += weight->second;
+            placed[component] = true;
+        }
+    }
+
+    std::vector<size_t> order(components.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return weights[a] > weights[b]; });
+    for (size_t i : order) {
+        if (placed[components[i]]) continue;
+        size_t lightest = std::min_element(load.begin(), load.end()) - load.begin();
+        groups[lightest].push_back(components[i]);
+        load[lightest] += weights[i];
+    }
+
+    // Then move as little as possible: the newest component of the heaviest group
+    // that has more than one goes to the lightest while that narrows the gap.
+    while (true) {
+        size_t heaviest = count;
+        for (size_t k = 0; k < count; ++k) {
+            if (groups[k].size() > 1 && (heaviest == count || load[k] > load[heaviest])) heaviest = k;
+        }
+        if (heaviest == count) break;
+        size_t lightest = std::min_element(load.begin(), load.end()) - load.begin();
+        size_t weight = weightOf[groups[heaviest].back()];
+        if (weight == 0 || load[lightest] + weight >= load[heaviest]) break;
+        groups[lightest].push_back(std::move(groups[heaviest].back()));
+        groups[heaviest].pop_back();
+        load[heaviest] -= weight;
+        load[lightest] += weight;
+    }
+    return groups;
+}
+
+void AddComponentToUnityBuild(const std::string& cmakeContent, const std::string& component, UnityFileUpdates& updates) {
+    ScopedTimer timer("AddComponentToUnityBuild");
+
+    auto groups = LoadUnityGroups(cmakeContent, updates);
+    if (groups.empty()) {
+        throw std::runtime_error("CMakeLists does not list '" + UnityFilePath(0) + "'");
+    }
+    for (const auto& group : groups) {
+        if (std::find(group.begin(), group.end(), component) != group.end()) return;
+    }
+
+    const SymbolIndex& symbols = GetSymbolIndex();
+    size_t lightest = 0;
+    size_t lightestLoad = SIZE_MAX;
+    for (size_t k = 0; k < groups.size(); ++k) {
+        size_t load = 0;
+        for (const auto& member : groups[k]) load += FunctionCount(symbols, member);
+        if (load < lightestLoad) {
+            lightest = k;
+            lightestLoad = load;
+        }
+    }
+    groups[lightest].push_back(component);
+    updates[UnityFilePath(lightest)] = RenderUnityFile(groups[lightest]);
+    std::cout << "Added component '" << component << "' to unity file '" << UnityFilePath(lightest) << "'" << std::endl;
+}
+
+// Drops the line listing exactly 'path'. Returns true if there was one.
+static bool RemoveCMakeListsLine(std::string& cmakeContent, const std::string& path) {
+    for (size_t pos = cmakeContent.find(path); pos != std::string::npos; pos = cmakeContent.find(path, pos + 1)) {
+        size_t lineStart = cmakeContent.rfind('\n', pos);
+        size_t lineEnd = cmakeContent.find('\n', pos);
+        size_t from = lineStart == std::string::npos ? 0 : lineStart;
+        size_t to = lineEnd == std::string::npos ? cmakeContent.size() : lineEnd;
+        std::string_view line = std::string_view(cmakeContent).substr(from, to - from);
+        size_t first = line.find_first_not_of(" \t\r\n");
+        size_t last = line.find_last_not_of(" \t\r\n");
+        if (first == std::string_view::npos || line.substr(first, last + 1 - first) != path) continue;
+        cmakeContent.erase(from, to - from);
+        return true;
+    }
+    return false;
+}
+
+static void PrintUnityGroups(const std::vector<std::vector<std::string>>& groups, const SymbolIndex& symbols) {
+    for (size_t k = 0; k < groups.size(); ++k) {
+        size_t functions = 0;
+        for (const auto& component : groups[k]) functions += FunctionCount(symbols, component);
+        std::cout << "  " << UnityFilePath(k) << ": " << groups[k].size() << " components, " << functions << " functions" << std::endl;
+    }
+}
+
+int CMD_unity(const std::vector<std::string>& args) {
+    size_t count = 0;
+    bool off = args.size() == 2 && args[1] == "off";
+    bool status = args.size() == 1;
+    if (args.size() == 2 && !off) {
+        try {
+            size_t used = 0;
+            count = std::stoul(args[1], &used);
+            if (used != args[1].size()) count = 0;
+        }
+        catch (const std::exception&) {
+            count = 0;
+        }
+    }
+    if (!status && !off && count == 0) {
+        std::cout << "Usage: unity [<count>|off]" << std::endl;
+        std::cout << "'unity <count>' builds GLImpl as <count> unity files in '" << UNITY_DIRECTORY_PATH << "'," << std::endl;
+        std::cout << "balanced by function count, and lists them in '" << CMAKELISTS_FILE_PATH << "' instead of the" << std::endl;
+        std::cout << "component sources. Components keep their unity file when the count is changed;" << std::endl;
+        std::cout << "impl appends new ones to the lightest file. 'unity off' lists the components again." << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+
+    if (!IsFileExists(CMAKELISTS_FILE_PATH)) {
+        std::cerr << "CMakeLists file does not exist: " << CMAKELISTS_FILE_PATH << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    try {
+        std::string cmakeContent = GetFileContent(CMAKELISTS_FILE_PATH);
+        bool active = IsUnityBuildActive(cmakeContent);
+        auto previous = active ? LoadUnityGroups(cmakeContent) : std::vector<std::vector<std::string>>();
+        const SymbolIndex& symbols = GetSymbolIndex(DefaultImplOptions().jobs);
+
+        if (status) {
+            if (!active) {
+                std::cout << "Unity build: off" << std::endl;
+                return COMMAND_OK;
+            }
+            std::cout << "Unity build: " << previous.size() << " files" << std::endl;
+            PrintUnityGroups(previous, symbols);
+            return COMMAND_OK;
+        }
+
+        if (off) {
+            if (!active) {
+                std::cout << "Unity build is already off" << std::endl;
+                return COMMAND_OK;
+            }
+            for (size_t k = 0; k < previous.size(); ++k) RemoveCMakeListsLine(cmakeContent, UnityFilePath(k));
+            for (const auto& group : previous) {
+                for (const auto& component : group) AddGLImplSourceToCMakeListsContent(cmakeContent, ComponentSourcePath(component));
+            }
+            WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
+            std::cout << "Unity build: off. The files in '" << UNITY_DIRECTORY_PATH << "' are no longer built." << std::endl;
+            return COMMAND_OK;
+        }
+
+        // Every component with a source: those listed in CMakeLists and those
+        // already in unity files.
+        std::vector<std::string> components;
+        std::vector<size_t> weights;
+        for (const auto& component : ListComponents()) {
+            if (!IsFileExists(ComponentSourcePath(component))) continue;
+            bool listed = cmakeContent.find(ComponentSourcePath(component)) != std::string::npos;
+            bool grouped = std::any_of(previous.begin(), previous.end(), [&](const std::vector<std::string>& group) {
+                return std::find(group.begin(), group.end(), component) != group.end();
+            });
+            if (!listed && !grouped) continue;
+            components.push_back(component);
+            weights.push_back(FunctionCount(symbols, component));
+        }
+
+        auto groups = BalanceUnityGroups(previous, components, weights, count);
+        size_t rewritten = 0;
+        for (size_t k = 0; k < groups.size(); ++k) {
+            rewritten += WriteToFile(UnityFilePath(k), RenderUnityFile(groups[k]));
+        }
+
+        for (const auto& component : components) RemoveCMakeListsLine(cmakeContent, ComponentSourcePath(component));
+        for (size_t k = count; k < previous.size(); ++k) RemoveCMakeListsLine(cmakeContent, UnityFilePath(k));
+        // Each source goes right below the insertion point, so add them last to first.
+        for (size_t k = count; k-- > 0;) AddGLImplSourceToCMakeListsContent(cmakeContent, UnityFilePath(k));
+        WriteToFile(CMAKELISTS_FILE_PATH, cmakeContent);
+
+        std::cout << "Unity build: " << count << " files, " << rewritten << " rewritten" << std::endl;
+        PrintUnityGroups(groups, symbols);
+        if (previous.size() > count) {
+            std::cout << "Files from " << UnityFilePath(count) << " on are no longer built." << std::endl;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+    return COMMAND_OK;
+}
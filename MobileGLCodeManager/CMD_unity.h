@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <map>
+#include <vector>
+
+// Unity build of the GLImpl sources: GL_IMPL_DIRECTORY_PATH/Unity/GLImpl_Unity<k>.cpp
+// each #include a group of component sources, and CMakeLists.txt lists those
+// files instead of the components. The unity files themselves record which
+// component goes where.
+extern const char* UNITY_DIRECTORY_PATH;
+
+std::string UnityFilePath(size_t k);
+
+// True if the CMakeLists content lists unity files.
+bool IsUnityBuildActive(const std::string& cmakeContent);
+
+// The components of every unity file the CMakeLists content lists, in file order.
+// Files left over from a larger count are not built and do not count.
+std::vector<std::vector<std::string>> LoadUnityGroups(const std::string& cmakeContent);
+
+// New content of unity files by path, not yet written.
+using UnityFileUpdates = std::map<std::string, std::string>;
+
+// Appends a new component to the unity file with the fewest functions, so only
+// that file has to be rebuilt. Does nothing if some unity file already has it.
+// Only the unity files 'cmakeContent' lists are considered. Nothing is written:
+// the new file content goes into 'updates', which later calls build on, for the
+// caller to write along with the rest of its changes.
+void AddComponentToUnityBuild(const std::string& cmakeContent, const std::string& component, UnityFileUpdates& updates);
+
+// Spreads components over 'count' groups balanced by 'weights' (function counts).
+// Components already in a group that is kept stay where they are, in the same
+// order; the rest, heaviest first, join the lightest group. After that, the
+// newest component of the heaviest group with more than one moves to the
+// lightest group while this narrows the gap, so few groups change. With
+// 'previous' empty this is a plain longest-processing-time-first split.
+std::vector<std::vector<std::string>> BalanceUnityGroups(const std::vector<std::vector<std::string>>& previous,
+    const std::vector<std::string>& components, const std::vector<size_t>& weights, size_t count);
@@ -0,0 +1,275 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include "CMD_implementFunction.h"
+#include "CMD_unity.h"
+#include "Commands.h"
+#include "ComponentScanner.h"
+#include "DefinitionIndex.h"
+#include "DefinitionScanner.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+#include "Progress.h"
+#include "ThreadPool.h"
+
+// Problem kinds, in the order they are reported.
+enum class ProblemKind {
+    SignatureMismatch,
+    OrphanedDeclaration,
+    UndeclaredDefinition,
+    StubMismatch,
+    DuplicateSymbol,
+    MissingCMakeEntry,
+};
+
+static const char* PROBLEM_HEADINGS[] = {
+    "Signatures that differ from Definitions.cpp:",
+    "Declared but defined in no component:",
+    "Defined but not declared in the component header:",
+    "Stub markers that do not match the components:",
+    "Duplicate symbols:",
+    "Component sources missing from CMakeLists:",
+};
+
+struct VerifyProblem {
+    ProblemKind kind;
+    std::string location; // "<file>:<line>", or a file
+    std::string message;
+};
+
+struct ScannedComponent {
+    std::string header;
+    std::string source;
+    std::vector<ComponentSymbol> declared;
+    std::vector<ComponentSymbol> defined;
+    std::vector<VerifyProblem> problems;
+};
+
+// Spelling differences that do not change a type: runs of whitespace, and
+// whitespace next to punctuation ("const GLubyte *" vs "const GLubyte*").
+static std::string NormalizeType(std::string_view text) {
+    auto isPunctuation = [](char c) { return std::string_view("*&,()[]<>").find(c) != std::string_view::npos; };
+    std::string normalized;
+    bool pendingSpace = false;
+    for (char c : TrimWhitespace(text)) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            pendingSpace = true;
+            continue;
+        }
+        if (pendingSpace && !normalized.empty() && !isPunctuation(c) && !isPunctuation(normalized.back())) normalized += ' ';
+        pendingSpace = false;
+        normalized += c;
+    }
+    return normalized;
+}
+
+static std::vector<std::string> NormalizeParams(const std::vector<std::string_view>& params) {
+    std::vector<std::string> normalized;
+    for (auto param : params) normalized.push_back(NormalizeType(param));
+    // "()" and "(void)" declare the same thing.
+    if (normalized.size() == 1 && (normalized[0].empty() || normalized[0] == "void")) normalized.clear();
+    return normalized;
+}
+
+static std::string JoinParams(const std::vector<std::string>& params) {
+    std::string joined;
+    for (const auto& param : params) joined += (joined.empty() ? "" : ", ") + param;
+    return joined;
+}
+
+static std::string Location(const std::string& path, size_t line) {
+    return path + ":" + std::to_string(line);
+}
+
+// Compares a component's function against its Definitions.cpp entry.
+static void CheckSignature(const ComponentSymbol& symbol, const DefinitionEntry& entry, const std::string& path,
+    std::vector<VerifyProblem>& problems) {
+    std::string returnType = NormalizeType(symbol.returnType);
+    std::string expectedReturnType = NormalizeType(entry.returnType);
+    if (returnType != expectedReturnType) {
+        problems.push_back({ ProblemKind::SignatureMismatch, Location(path, symbol.line),
+            std::string(symbol.name) + " returns '" + returnType + "', Definitions.cpp:" + std::to_string(entry.firstLine) +
+            " '" + expectedReturnType + "'" });
+    }
+    std::vector<std::string> params = NormalizeParams(SplitMacroArguments(symbol.params));
+    std::vector<std::string> expectedParams = NormalizeParams(entry.params);
+    if (params != expectedParams) {
+        problems.push_back({ ProblemKind::SignatureMismatch, Location(path, symbol.line),
+            std::string(symbol.name) + "(" + JoinParams(params) + "), Definitions.cpp:" + std::to_string(entry.firstLine) +
+            " (" + JoinParams(expectedParams) + ")" });
+    }
+}
+
+// Everything that can be checked from one component on its own.
+static void ScanComponent(const std::string& component, const DefinitionIndex& index, ScannedComponent& scanned) {
+    std::string headerPath = ComponentHeaderPath(component);
+    std::string sourcePath = ComponentSourcePath(component);
+    if (IsFileExists(headerPath)) scanned.header = GetFileContent(headerPath);
+    if (IsFileExists(sourcePath)) scanned.source = GetFileContent(sourcePath);
+    scanned.declared = ScanComponentDeclarations(scanned.header);
+    scanned.defined = ScanComponentDefinitions(scanned.source);
+
+    std::unordered_map<std::string_view, size_t> declaredLine;
+    for (const auto& symbol : scanned.declared) {
+        auto [it, inserted] = declaredLine.emplace(symbol.name, symbol.line);
+        if (!inserted) {
+            scanned.problems.push_back({ ProblemKind::DuplicateSymbol, Location(headerPath, symbol.line),
+                std::string(symbol.name) + " is also declared on line " + std::to_string(it->second) });
+            continue;
+        }
+        if (const DefinitionEntry* entry = index.Find(symbol.name)) CheckSignature(symbol, *entry, headerPath, scanned.problems);
+    }
+
+    std::unordered_map<std::string_view, size_t> definedLine;
+    for (const auto& symbol : scanned.defined) {
+        auto [it, inserted] = definedLine.emplace(symbol.name, symbol.line);
+        if (!inserted) {
+            scanned.problems.push_back({ ProblemKind::DuplicateSymbol, Location(sourcePath, symbol.line),
+                std::string(symbol.name) + " is also defined on line " + std::to_string(it->second) });
+            continue;
+        }
+        const DefinitionEntry* entry = index.Find(symbol.name);
+        if (!entry) continue; // a helper of the component
+        CheckSignature(symbol, *entry, sourcePath, scanned.problems);
+        if (!declaredLine.contains(symbol.name)) {
+            scanned.problems.push_back({ ProblemKind::UndeclaredDefinition, Location(sourcePath, symbol.line),
+                std::string(symbol.name) + " is not declared in '" + headerPath + "'" });
+        }
+    }
+}
+
+int CMD_verify(const std::vector<std::string>& args) {
+    unsigned jobs = HardwareJobCount();
+    bool usageError = false;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "-j" && i + 1 < args.size()) {
+            try {
+                size_t used = 0;
+                unsigned long value = std::stoul(args[++i], &used);
+                if (used != args[i].size()) usageError = true;
+                else jobs = value == 0 ? HardwareJobCount() : static_cast<unsigned>(value);
+            }
+            catch (const std::exception&) {
+                usageError = true;
+            }
+        } else {
+            usageError = true;
+        }
+    }
+    if (usageError) {
+        std::cout << "Usage: verify [-j <jobs>]" << std::endl;
+        std::cout << "Cross-checks Definitions.cpp, the component headers and sources and CMakeLists:" << std::endl;
+        std::cout << "signatures, stub markers, orphaned declarations, duplicate symbols and component" << std::endl;
+        std::cout << "sources that are not built. Components are scanned on <jobs> threads (default:" << std::endl;
+        std::cout << "one per hardware thread, as does 0). Fails if anything is reported." << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+
+    if (!IsFileExists(DEFINITIONS_FILE_PATH)) {
+        std::cerr << "Definitions file does not exist '" << DEFINITIONS_FILE_PATH << "'" << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    std::vector<VerifyProblem> problems;
+    size_t componentCount = 0;
+    size_t definitionCount = 0;
+    try {
+        ScopedTimer timer("Verify");
+        const DefinitionIndex& index = GetDefinitionIndex(DEFINITIONS_FILE_PATH);
+        definitionCount = index.Entries().size();
+        std::vector<std::string> components = ListComponents();
+        componentCount = components.size();
+
+        std::vector<ScannedComponent> scanned(components.size());
+        AddProgressTotal(components.size());
+        ParallelFor(components.size(), jobs, [&](size_t i) {
+            ThrowIfCancelled();
+            ScanComponent(components[i], index, scanned[i]);
+            AddProgressDone();
+        });
+
+        for (auto& component : scanned) {
+            problems.insert(problems.end(), component.problems.begin(), component.problems.end());
+        }
+
+        // Checks across components, in component order.
+        std::unordered_map<std::string_view, size_t> definingComponent;
+        for (size_t i = 0; i < components.size(); ++i) {
+            // Repeats within the file were reported by ScanComponent.
+            std::unordered_set<std::string_view> seen;
+            for (const auto& symbol : scanned[i].defined) {
+                if (!seen.insert(symbol.name).second) continue;
+                auto [it, inserted] = definingComponent.emplace(symbol.name, i);
+                if (inserted || !index.Find(symbol.name)) continue;
+                problems.push_back({ ProblemKind::DuplicateSymbol, Location(ComponentSourcePath(components[i]), symbol.line),
+                    std::string(symbol.name) + " is also defined in component '" + components[it->second] + "'" });
+            }
+        }
+        for (size_t i = 0; i < components.size(); ++i) {
+            for (const auto& symbol : scanned[i].declared) {
+                if (definingComponent.contains(symbol.name)) continue;
+                const DefinitionEntry* entry = index.Find(symbol.name);
+                problems.push_back({ ProblemKind::OrphanedDeclaration, Location(ComponentHeaderPath(components[i]), symbol.line),
+                    std::string(symbol.name) + (entry ? "" : ", which Definitions.cpp does not list either") });
+            }
+        }
+
+        std::unordered_map<std::string_view, size_t> firstEntry;
+        for (const auto& entry : index.Entries()) {
+            auto [it, inserted] = firstEntry.emplace(entry.name, entry.firstLine);
+            if (!inserted) {
+                problems.push_back({ ProblemKind::DuplicateSymbol, Location(DEFINITIONS_FILE_PATH, entry.firstLine),
+                    std::string(entry.name) + " is also listed on line " + std::to_string(it->second) });
+                continue;
+            }
+            auto defined = definingComponent.find(entry.name);
+            if (entry.isStub && defined != definingComponent.end()) {
+                problems.push_back({ ProblemKind::StubMismatch, Location(DEFINITIONS_FILE_PATH, entry.firstLine),
+                    std::string(entry.name) + " is still a stub, but component '" + components[defined->second] + "' defines it" });
+            } else if (!entry.isStub && defined == definingComponent.end()) {
+                problems.push_back({ ProblemKind::StubMismatch, Location(DEFINITIONS_FILE_PATH, entry.firstLine),
+                    std::string(entry.name) + " is not a stub, but no component defines it" });
+            }
+        }
+
+        if (IsFileExists(CMAKELISTS_FILE_PATH)) {
+            std::string cmakeContent = GetFileContent(CMAKELISTS_FILE_PATH);
+            std::unordered_set<std::string> unityComponents;
+            if (IsUnityBuildActive(cmakeContent)) {
+                for (const auto& group : LoadUnityGroups(cmakeContent)) unityComponents.insert(group.begin(), group.end());
+            }
+            for (size_t i = 0; i < components.size(); ++i) {
+                std::string sourcePath = ComponentSourcePath(components[i]);
+                if (scanned[i].source.empty() && !IsFileExists(sourcePath)) continue;
+                if (cmakeContent.find(sourcePath) != std::string::npos || unityComponents.contains(components[i])) continue;
+                problems.push_back({ ProblemKind::MissingCMakeEntry, sourcePath, "not listed in '" + std::string(CMAKELISTS_FILE_PATH) + "'" });
+            }
+        } else {
+            std::cerr << "CMakeLists file does not exist: " << CMAKELISTS_FILE_PATH << std::endl;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    std::stable_sort(problems.begin(), problems.end(), [](const VerifyProblem& a, const VerifyProblem& b) { return a.kind < b.kind; });
+    for (size_t i = 0; i < problems.size(); ++i) {
+        if (i == 0 || problems[i].kind != problems[i - 1].kind) {
+            std::cout << PROBLEM_HEADINGS[static_cast<size_t>(problems[i].kind)] << std::endl;
+        }
+        std::cout << "  " << problems[i].location << ": " << problems[i].message << std::endl;
+    }
+    std::cout << "Verified " << componentCount << " components against " << definitionCount << " definitions: ";
+    if (problems.empty()) {
+        std::cout << "no problems found" << std::endl;
+        return COMMAND_OK;
+    }
+    std::cout << problems.size() << " problem(s)" << std::endl;
+    return COMMAND_FAILED;
+}
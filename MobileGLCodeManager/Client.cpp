@@ -0,0 +1,111 @@
+// Thin client for "MobileGLCodeManager serve <socket>".
+//   MobileGLCodeManagerClient <socket> <command> [args...]   run one command
+//   MobileGLCodeManagerClient <socket>                       run commands read from stdin
+// Prints each response and exits with the status of the last failing command.
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "Commands.h"
+#include "Server.h"
+
+static bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Reads one response, echoes its output to stdout and returns its status, or -1
+// if the connection closed or the status line is garbled.
+static int ReadResponse(int fd, std::string& pending) {
+    const std::string marker = SERVER_STATUS_MARKER;
+    char buffer[4096];
+    while (true) {
+        size_t markerPos = pending.find(marker);
+        if (markerPos != std::string::npos) {
+            size_t newline = pending.find('\n', markerPos);
+            if (newline != std::string::npos) {
+                std::cout << std::string_view(pending).substr(0, markerPos) << std::flush;
+                std::string_view text = std::string_view(pending).substr(markerPos + marker.size(), newline - markerPos - marker.size());
+                int status = 0;
+                auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), status);
+                if (error != std::errc() || end != text.data() + text.size() || status < 0) {
+                    std::cerr << "Invalid status line from server: '" << text << "'" << std::endl;
+                    return -1;
+                }
+                pending.erase(0, newline + 1);
+                return status;
+            }
+        }
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            std::cerr << "Connection closed by server" << std::endl;
+            return -1;
+        }
+        pending.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <socket> [<command> [args...]]" << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+
+    sockaddr_un address{};
+    std::string socketPath = argv[1];
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return COMMAND_FAILED;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Cannot connect to " << socketPath << ": " << strerror(errno) << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    std::string pending;
+    int exitCode = COMMAND_OK;
+    auto execute = [&](const std::string& line) {
+        if (!SendAll(fd, line + "\n")) return false;
+        int status = ReadResponse(fd, pending);
+        if (status < 0) {
+            exitCode = COMMAND_FAILED;
+            return false;
+        }
+        if (status != COMMAND_OK) exitCode = status;
+        return true;
+    };
+
+    if (argc > 2) {
+        std::string line = argv[2];
+        for (int i = 3; i < argc; ++i) line += std::string(" ") + argv[i];
+        execute(line);
+    } else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            if (!execute(line)) break;
+        }
+    }
+
+    close(fd);
+    return exitCode;
+}
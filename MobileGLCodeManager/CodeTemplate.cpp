@@ -0,0 +1,192 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <stdexcept>
+
+#include "CodeTemplate.h"
+#include "CMD_implementFunction.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+
+namespace fs = std::filesystem;
+
+struct FieldName {
+    std::string_view name;
+    TemplateField field;
+};
+
+static constexpr FieldName FIELD_NAMES[] = {
+    { "return_type", TemplateField::ReturnType },
+    { "name", TemplateField::Name },
+    { "params", TemplateField::Params },
+    { "args", TemplateField::Args },
+    { "component", TemplateField::Component },
+    { "indent", TemplateField::Indent },
+    { "default_return", TemplateField::DefaultReturn },
+    { "includes", TemplateField::Includes },
+};
+
+static bool IsFieldNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || c == '_';
+}
+
+static bool IsBlank(std::string_view text) {
+    return text.find_first_not_of(" \t") == std::string_view::npos;
+}
+
+CodeTemplate CodeTemplate::Compile(std::string_view source, const std::string& origin) {
+    CodeTemplate result;
+    result.text.assign(source);
+    result.crlf = DetectNewline(result.text) == "\r\n";
+    std::string_view text = result.text;
+
+    size_t lineStart = 0;
+    size_t lineNumber = 1;
+    while (true) {
+        size_t lineEnd = text.find('\n', lineStart);
+        size_t contentEnd = lineEnd == std::string_view::npos ? text.size() : lineEnd;
+        if (contentEnd > lineStart && text[contentEnd - 1] == '\r') --contentEnd;
+
+        Line line;
+        line.firstSegment = static_cast<uint32_t>(result.segments.size());
+        bool hasField = false;
+        bool blankLiterals = true;
+        auto addLiteral = [&](size_t from, size_t to) {
+            if (from == to) return;
+            blankLiterals = blankLiterals && IsBlank(text.substr(from, to - from));
+            Segment segment;
+            segment.offset = static_cast<uint32_t>(from);
+            segment.length = static_cast<uint32_t>(to - from);
+            result.segments.push_back(segment);
+        };
+
+        size_t literalStart = lineStart;
+        size_t pos = lineStart;
+        while (true) {
+            size_t open = text.substr(0, contentEnd).find("{{", pos);
+            if (open == std::string_view::npos) break;
+            size_t nameEnd = open + 2;
+            while (nameEnd < contentEnd && IsFieldNameChar(text[nameEnd])) ++nameEnd;
+            if (nameEnd == open + 2 || text.substr(nameEnd, 2) != "}}") {
+                // Not a placeholder, e.g. "{{0}}" in an initializer.
+                pos = open + 1;
+                continue;
+            }
+
+            std::string_view name = text.substr(open + 2, nameEnd - open - 2);
+            const FieldName* known = nullptr;
+            for (const auto& candidate : FIELD_NAMES) {
+                if (candidate.name == name) known = &candidate;
+            }
+            if (!known) {
+                throw std::runtime_error("Unknown placeholder '{{" + std::string(name) + "}}' in template " +
+                    origin + ":" + std::to_string(lineNumber));
+            }
+
+            addLiteral(literalStart, open);
+            Segment segment;
+            segment.isField = true;
+            segment.field = known->field;
+            result.segments.push_back(segment);
+            result.usedFields |= 1u << static_cast<unsigned>(known->field);
+            hasField = true;
+            pos = literalStart = nameEnd + 2;
+        }
+        addLiteral(literalStart, contentEnd);
+
+        line.segmentCount = static_cast<uint32_t>(result.segments.size()) - line.firstSegment;
+        line.optional = hasField && blankLiterals;
+        result.lines.push_back(line);
+
+        if (lineEnd == std::string_view::npos) break;
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+    }
+    return result;
+}
+
+static std::string_view FieldValue(const TemplateValues& values, TemplateField field) {
+    switch (field) {
+    case TemplateField::ReturnType: return values.returnType;
+    case TemplateField::Name: return values.name;
+    case TemplateField::Params: return values.params;
+    case TemplateField::Args: return values.args;
+    case TemplateField::Component: return values.component;
+    case TemplateField::Indent: return values.indent;
+    case TemplateField::DefaultReturn: return values.defaultReturn;
+    case TemplateField::Includes: return values.includes;
+    }
+    return {};
+}
+
+void CodeTemplate::Expand(std::string& out, const TemplateValues& values, std::string_view newline) const {
+    bool firstLine = true;
+    for (const Line& line : lines) {
+        const Segment* begin = segments.data() + line.firstSegment;
+        const Segment* end = begin + line.segmentCount;
+
+        if (line.optional) {
+            bool empty = true;
+            for (const Segment* segment = begin; segment != end && empty; ++segment) {
+                empty = !segment->isField || FieldValue(values, segment->field).empty();
+            }
+            if (empty) continue;
+        }
+
+        if (!firstLine) out += newline;
+        firstLine = false;
+        out += values.indent;
+        for (const Segment* segment = begin; segment != end; ++segment) {
+            if (segment->isField) out += FieldValue(values, segment->field);
+            else out.append(text, segment->offset, segment->length);
+        }
+    }
+}
+
+struct CachedTemplate {
+    std::shared_ptr<const CodeTemplate> compiled;
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+};
+
+static std::mutex templateMutex;
+static std::unordered_map<std::string, CachedTemplate> templateCache; // by path; built-ins by "<builtin>/<fileName>"
+
+// Returns nullptr if there is no such file.
+static std::shared_ptr<const CodeTemplate> LoadTemplateFile(const std::string& path) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec) return nullptr;
+    fs::file_time_type mtime = fs::last_write_time(path, ec);
+    if (ec) return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(templateMutex);
+        auto it = templateCache.find(path);
+        if (it != templateCache.end() && it->second.size == size && it->second.mtime == mtime) return it->second.compiled;
+    }
+
+    ScopedTimer timer("CompileCodeTemplate");
+    auto compiled = std::make_shared<const CodeTemplate>(CodeTemplate::Compile(ReadFileFromDisk(path), path));
+    std::lock_guard<std::mutex> lock(templateMutex);
+    templateCache[path] = CachedTemplate{ compiled, size, mtime };
+    return compiled;
+}
+
+std::shared_ptr<const CodeTemplate> LoadCodeTemplate(const std::string& fileName, const std::string& component, std::string_view builtin) {
+    std::string directory = TEMPLATES_DIRECTORY_PATH;
+    if (!component.empty()) {
+        if (auto found = LoadTemplateFile(directory + "/" + component + "/" + fileName)) return found;
+    }
+    if (auto found = LoadTemplateFile(directory + "/" + fileName)) return found;
+
+    std::string key = "<builtin>/" + fileName;
+    std::lock_guard<std::mutex> lock(templateMutex);
+    auto& cached = templateCache[key];
+    if (!cached.compiled) cached.compiled = std::make_shared<const CodeTemplate>(CodeTemplate::Compile(builtin, key));
+    return cached.compiled;
+}
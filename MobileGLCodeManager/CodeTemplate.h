@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+enum class TemplateField : uint8_t {
+    ReturnType,    // {{return_type}}
+    Name,          // {{name}}
+    Params,        // {{params}}
+    Args,          // {{args}}: parameter names, comma separated
+    Component,     // {{component}}
+    Indent,        // {{indent}}: indentation of the insertion point
+    DefaultReturn, // {{default_return}}: "return {};", empty for void functions
+    Includes,      // {{includes}}: the include lines of a new component header
+};
+
+// Values substituted for the placeholders. Nothing is copied; the views only
+// have to live until Expand returns.
+struct TemplateValues {
+    std::string_view returnType;
+    std::string_view name;
+    std::string_view params;
+    std::string_view args;
+    std::string_view component;
+    std::string_view indent;
+    std::string_view defaultReturn;
+    std::string_view includes;
+};
+
+// A code template parsed once into literal and placeholder segments.
+//
+// Expand appends straight to the output: every line is prefixed with the indent
+// and lines are joined with the requested newline. A line holding nothing but
+// whitespace and placeholders is left out when they all expand to nothing, so a
+// "{{default_return}}" line disappears for void functions.
+class CodeTemplate {
+public:
+    // Throws std::runtime_error naming 'origin' on an unknown placeholder.
+    static CodeTemplate Compile(std::string_view text, const std::string& origin);
+
+    void Expand(std::string& out, const TemplateValues& values, std::string_view newline) const;
+
+    bool Uses(TemplateField field) const { return (usedFields >> static_cast<unsigned>(field)) & 1u; }
+    // The newline the template itself was written with.
+    std::string_view Newline() const { return crlf ? "\r\n" : "\n"; }
+
+private:
+    struct Segment {
+        bool isField = false;
+        TemplateField field = TemplateField::Name;
+        uint32_t offset = 0; // literal text in 'text'
+        uint32_t length = 0;
+    };
+    struct Line {
+        uint32_t firstSegment = 0;
+        uint32_t segmentCount = 0;
+        bool optional = false; // only whitespace besides placeholders
+    };
+
+    std::string text;
+    std::vector<Segment> segments;
+    std::vector<Line> lines;
+    uint32_t usedFields = 0;
+    bool crlf = false;
+};
+
+// Finds a template in the workspace: TEMPLATES_DIRECTORY_PATH/<component>/<fileName>,
+// then TEMPLATES_DIRECTORY_PATH/<fileName>, and otherwise compiles 'builtin'.
+// Compiled templates are cached and only recompiled when their file changes.
+// Safe to call from several threads.
+std::shared_ptr<const CodeTemplate> LoadCodeTemplate(const std::string& fileName, const std::string& component, std::string_view builtin);
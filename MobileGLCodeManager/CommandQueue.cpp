@@ -0,0 +1,179 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "CommandQueue.h"
+#include "Commands.h"
+#include "Progress.h"
+
+// Finished commands that took at least this long report it, with their progress.
+static constexpr double REPORT_DONE_SECONDS = 1.0;
+
+static CommandQueue* activeCommandQueue = nullptr;
+
+CommandQueue* GetActiveCommandQueue() {
+    return activeCommandQueue;
+}
+
+void SetActiveCommandQueue(CommandQueue* queue) {
+    activeCommandQueue = queue;
+}
+
+static std::string JoinTokens(const std::vector<std::string>& tokens) {
+    std::string line;
+    for (const auto& token : tokens) {
+        if (!line.empty()) line += ' ';
+        line += token;
+    }
+    return line;
+}
+
+CommandQueue::~CommandQueue() {
+    Wait();
+}
+
+size_t CommandQueue::Submit(std::vector<std::string> tokens) {
+    size_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextId++;
+        jobs.push_back(Job{ id, std::move(tokens), JobState::Queued });
+    }
+    worker.Submit([this, id] { Run(id); });
+    return id;
+}
+
+void CommandQueue::Run(size_t id) {
+    std::vector<std::string> tokens;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; });
+        if (it == jobs.end()) return;
+        if (it->state == JobState::Dropped) {
+            jobs.erase(it);
+            return;
+        }
+        it->state = JobState::Running;
+        tokens = it->tokens;
+        // Under the lock, so that a CancelRunning from now on is not reset.
+        BeginCommandProgress();
+    }
+
+    int status = COMMAND_FAILED;
+    try {
+        status = RunCommand(tokens);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    ProgressSnapshot progress = GetCommandProgress();
+    if (status != COMMAND_OK && IsCancellationRequested()) {
+        std::cout << "[" << id << "] cancelled: " << JoinTokens(tokens) << " (" << FormatProgress(progress) << ")" << std::endl;
+    } else if (progress.seconds >= REPORT_DONE_SECONDS) {
+        std::cout << "[" << id << "] " << (status == COMMAND_OK ? "done" : "failed") << ": " << JoinTokens(tokens)
+            << " (" << FormatProgress(progress) << ")" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.id == id; }), jobs.end());
+}
+
+bool CommandQueue::CancelRunning() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& job : jobs) {
+        if (job.state == JobState::Running) {
+            RequestCancellation();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CommandQueue::Cancel(size_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& job : jobs) {
+        if (job.id != id) continue;
+        if (job.state == JobState::Running) RequestCancellation();
+        else if (job.state == JobState::Queued) job.state = JobState::Dropped;
+        else return false;
+        return true;
+    }
+    return false;
+}
+
+void CommandQueue::CancelAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& job : jobs) {
+        if (job.state == JobState::Running) RequestCancellation();
+        else job.state = JobState::Dropped;
+    }
+}
+
+size_t CommandQueue::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::count_if(jobs.begin(), jobs.end(), [](const Job& job) { return job.state != JobState::Dropped; });
+}
+
+void CommandQueue::Wait() {
+    worker.Wait();
+}
+
+void CommandQueue::PrintJobs(std::ostream& out) const {
+    // Written after the lock is released; output goes through the line editor.
+    std::ostringstream listing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& job : jobs) {
+            if (job.state == JobState::Dropped) continue;
+            listing << "[" << job.id << "] ";
+            if (job.state == JobState::Running) {
+                listing << (IsCancellationRequested() ? "cancelling " : "running    ") << JoinTokens(job.tokens)
+                    << " (" << FormatProgress(GetCommandProgress()) << ")\n";
+            } else {
+                listing << "queued     " << JoinTokens(job.tokens) << "\n";
+            }
+        }
+    }
+    std::string text = listing.str();
+    out << (text.empty() ? "No jobs\n" : text) << std::flush;
+}
+
+int CMD_jobs(const std::vector<std::string>& args) {
+    CommandQueue* queue = GetActiveCommandQueue();
+    if (args.size() == 1) {
+        if (queue) queue->PrintJobs(std::cout);
+        else std::cout << "No jobs" << std::endl;
+        return COMMAND_OK;
+    }
+    if (args.size() == 3 && args[1] == "cancel") {
+        if (args[2] == "all") {
+            if (queue) queue->CancelAll();
+            return COMMAND_OK;
+        }
+        size_t id = 0;
+        try {
+            size_t used = 0;
+            id = std::stoul(args[2], &used);
+            if (used != args[2].size()) id = 0;
+        }
+        catch (const std::exception&) {
+            id = 0;
+        }
+        if (id != 0) {
+            if (!queue || !queue->Cancel(id)) {
+                std::cerr << "No job [" << id << "]" << std::endl;
+                return COMMAND_FAILED;
+            }
+            return COMMAND_OK;
+        }
+    }
+    std::cout << "Usage: jobs [cancel <id>|all]" << std::endl;
+    std::cout << "At the prompt, commands run in the background one after another; lines entered" << std::endl;
+    std::cout << "meanwhile are queued. 'jobs' lists them with the progress of the running one." << std::endl;
+    std::cout << "Ctrl-C cancels the running command at its next safe point: files it writes" << std::endl;
+    std::cout << "together are either all written or left as they were." << std::endl;
+    return COMMAND_USAGE_ERROR;
+}
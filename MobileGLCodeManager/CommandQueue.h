@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <ostream>
+
+#include "ThreadPool.h"
+
+// Runs the prompt's commands one after another on a worker thread, so the prompt
+// stays responsive: lines entered meanwhile queue up behind the running command,
+// Ctrl-C cancels it, and 'jobs' shows its progress. Commands keep running one at
+// a time, as they share files and caches.
+class CommandQueue {
+public:
+    CommandQueue() = default;
+    // Waits for the queued commands.
+    ~CommandQueue();
+
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    // Returns the job number.
+    size_t Submit(std::vector<std::string> tokens);
+
+    // Asks the running command to stop. Returns false if none is running. Prints
+    // nothing, so it can be called from the line editor.
+    bool CancelRunning();
+    // Drops a queued job or cancels the running one; false if there is no such job.
+    bool Cancel(size_t id);
+    void CancelAll();
+
+    // Jobs queued or running.
+    size_t Pending() const;
+    void Wait();
+
+    void PrintJobs(std::ostream& out) const;
+
+private:
+    enum class JobState { Queued, Running, Dropped };
+    struct Job {
+        size_t id = 0;
+        std::vector<std::string> tokens;
+        JobState state = JobState::Queued;
+    };
+
+    void Run(size_t id);
+
+    mutable std::mutex mutex;
+    std::deque<Job> jobs; // in order; the running one first
+    size_t nextId = 1;
+    ThreadPool worker{ 1 };
+};
+
+// The interactive prompt's queue, or nullptr when commands run in the foreground.
+CommandQueue* GetActiveCommandQueue();
+void SetActiveCommandQueue(CommandQueue* queue);
+
+int CMD_jobs(const std::vector<std::string>& args);
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+// Result of a command. In CLI and script mode it also becomes the process exit code.
+enum CommandStatus : int {
+    COMMAND_OK = 0,
+    COMMAND_FAILED = 1,
+    COMMAND_USAGE_ERROR = 2,
+};
+
+using CommandHandler = std::function<int(const std::vector<std::string>& args)>;
+
+extern std::unordered_map<std::string, CommandHandler> commandMap;
+
+std::vector<std::string> split(const std::string& line);
+
+// Looks up tokens[0] in commandMap and runs it.
+int RunCommand(const std::vector<std::string>& tokens);
@@ -0,0 +1,245 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+#include <filesystem>
+
+#include "Completion.h"
+#include "CMD_implementFunction.h"
+#include "CommandQueue.h"
+#include "Commands.h"
+#include "ComponentScanner.h"
+#include "DefinitionIndex.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+
+namespace fs = std::filesystem;
+
+std::string_view CompletionIndex::At(size_t i) const {
+    return std::string_view(pool.c_str() + offsets[i]);
+}
+
+void CompletionIndex::Assign(const std::vector<std::string_view>& names) {
+    std::vector<std::string_view> sorted = names;
+    if (!std::is_sorted(sorted.begin(), sorted.end())) std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    size_t poolSize = 0;
+    for (auto name : sorted) poolSize += name.size() + 1;
+    std::string newPool;
+    newPool.reserve(poolSize);
+    std::vector<uint32_t> newOffsets;
+    newOffsets.reserve(sorted.size());
+    for (auto name : sorted) {
+        newOffsets.push_back(static_cast<uint32_t>(newPool.size()));
+        newPool.append(name);
+        newPool.push_back('\0');
+    }
+    pool = std::move(newPool);
+    offsets = std::move(newOffsets);
+}
+
+static std::string_view CommonPrefix(std::string_view a, std::string_view b) {
+    size_t n = 0;
+    while (n < a.size() && n < b.size() && a[n] == b[n]) ++n;
+    return a.substr(0, n);
+}
+
+size_t CompletionIndex::Match(std::string_view prefix, size_t limit, std::vector<std::string>& out, std::string& commonPrefix) const {
+    auto first = std::lower_bound(offsets.begin(), offsets.end(), prefix, [this](uint32_t offset, std::string_view value) {
+        return std::string_view(pool.c_str() + offset) < value;
+    });
+    // Matches are contiguous, so the range ends where names stop sharing the prefix.
+    auto last = std::partition_point(first, offsets.end(), [&](uint32_t offset) {
+        return std::string_view(pool.c_str() + offset).starts_with(prefix);
+    });
+    if (first == last) return 0;
+
+    // In a sorted range, the first and last names share the least.
+    commonPrefix = CommonPrefix(At(first - offsets.begin()), At(last - 1 - offsets.begin()));
+    for (auto it = first; it != last && out.size() < limit; ++it) {
+        out.emplace_back(At(it - offsets.begin()));
+    }
+    return static_cast<size_t>(last - first);
+}
+
+// Function names from the definitions index. When the index is rebuilt with the
+// same names in the same order (the usual case after impl only flips stubs), the
+// sorted order is reused and only the stub subset is refreshed, without sorting.
+struct FunctionCompletions {
+    const DefinitionIndex* index = nullptr;
+    size_t generation = 0;
+    std::vector<std::string> fileOrderNames;
+    std::vector<uint32_t> sortedOrder; // indices into fileOrderNames, sorted by name
+    CompletionIndex all;
+    CompletionIndex stubs;
+};
+
+// The names as of the last sync; they are copies and never point into the index.
+static FunctionCompletions& LastFunctionCompletions() {
+    static FunctionCompletions state;
+    return state;
+}
+
+static FunctionCompletions& SyncFunctionCompletions() {
+    FunctionCompletions& state = LastFunctionCompletions();
+    const DefinitionIndex& index = GetDefinitionIndex(DEFINITIONS_FILE_PATH);
+    if (state.index == &index && state.generation == index.Generation()) return state;
+    ScopedTimer timer("SyncFunctionCompletions");
+
+    const auto& entries = index.Entries();
+    bool sameNames = entries.size() == state.fileOrderNames.size();
+    for (size_t i = 0; sameNames && i < entries.size(); ++i) {
+        sameNames = entries[i].name == state.fileOrderNames[i];
+    }
+
+    if (!sameNames) {
+        state.fileOrderNames.clear();
+        state.fileOrderNames.reserve(entries.size());
+        for (const auto& entry : entries) state.fileOrderNames.emplace_back(entry.name);
+        state.sortedOrder.resize(entries.size());
+        std::iota(state.sortedOrder.begin(), state.sortedOrder.end(), 0u);
+        std::sort(state.sortedOrder.begin(), state.sortedOrder.end(), [&](uint32_t a, uint32_t b) {
+            return state.fileOrderNames[a] < state.fileOrderNames[b];
+        });
+
+        std::vector<std::string_view> sortedNames;
+        sortedNames.reserve(entries.size());
+        for (uint32_t i : state.sortedOrder) sortedNames.push_back(state.fileOrderNames[i]);
+        state.all.Assign(sortedNames);
+    }
+
+    std::vector<std::string_view> stubNames;
+    for (uint32_t i : state.sortedOrder) {
+        if (entries[i].isStub) stubNames.push_back(state.fileOrderNames[i]);
+    }
+    state.stubs.Assign(stubNames);
+
+    state.index = &index;
+    state.generation = index.Generation();
+    return state;
+}
+
+// Commands queued at the prompt run on a worker thread, which rebuilds the
+// definitions index and writes component files as it goes. Completion runs on
+// the input thread, the only one that queues commands, so it reads the workspace
+// only while the queue is idle and otherwise offers what it read last.
+static bool IsWorkspaceBusy() {
+    CommandQueue* queue = GetActiveCommandQueue();
+    return queue && queue->Pending() > 0;
+}
+
+static const std::vector<std::string>& ComponentCompletions(bool busy) {
+    static std::vector<std::string> components;
+    if (!busy) components = ListComponents();
+    return components;
+}
+
+static const CompletionIndex& CommandCompletions() {
+    static CompletionIndex commands;
+    if (commands.Size() != commandMap.size()) {
+        std::vector<std::string_view> names;
+        for (const auto& kv : commandMap) names.push_back(kv.first);
+        commands.Assign(names);
+    }
+    return commands;
+}
+
+// Paths relative to the working directory; directories end with '/'.
+static void CompleteFilePath(std::string_view word, size_t limit, CompletionResult& result) {
+    size_t slash = word.rfind('/');
+    std::string directory(slash == std::string_view::npos ? std::string_view() : word.substr(0, slash + 1));
+    std::string_view namePrefix = slash == std::string_view::npos ? word : word.substr(slash + 1);
+
+    std::vector<std::pair<std::string, bool>> matches; // path, is a directory
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory.empty() ? fs::path(".") : fs::path(directory), ec)) {
+        std::string name = entry.path().filename().string();
+        if (!name.starts_with(namePrefix) || (name[0] == '.' && !namePrefix.starts_with("."))) continue;
+        std::error_code typeError;
+        bool isDirectory = entry.is_directory(typeError);
+        matches.emplace_back(directory + name + (isDirectory ? "/" : ""), isDirectory);
+    }
+    std::sort(matches.begin(), matches.end());
+
+    for (const auto& [path, isDirectory] : matches) {
+        result.commonPrefix = result.total == 0 ? path : std::string(CommonPrefix(result.commonPrefix, path));
+        ++result.total;
+        if (result.candidates.size() < limit) result.candidates.push_back(path);
+    }
+    result.spaceAfterUnique = !(matches.size() == 1 && matches[0].second);
+}
+
+CompletionResult CompleteCommandLine(const std::string& line, size_t cursor, size_t limit) {
+    ScopedTimer timer("CompleteCommandLine");
+    CompletionResult result;
+    cursor = std::min(cursor, line.size());
+    result.wordStart = cursor;
+    while (result.wordStart > 0 && line[result.wordStart - 1] != ' ') --result.wordStart;
+    std::string_view word = std::string_view(line).substr(result.wordStart, cursor - result.wordStart);
+
+    std::vector<std::string> tokens = split(line.substr(0, result.wordStart));
+    if (tokens.empty()) {
+        result.total = CommandCompletions().Match(word, limit, result.candidates, result.commonPrefix);
+        return result;
+    }
+    if (tokens[0] != "impl" || word.starts_with("-")) return result;
+
+    // "impl [-j <jobs>] [-p] <function_name>... <component>" and "impl -f <manifest_file>".
+    // Only the first positional argument is certainly a function; any later one
+    // may be another function or the component.
+    size_t position = 0;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i] == "-p") continue;
+        if (tokens[i] == "-j" || tokens[i] == "-f") {
+            if (i + 1 == tokens.size()) {
+                if (tokens[i] == "-f") CompleteFilePath(word, limit, result);
+                return result;
+            }
+            ++i;
+            continue;
+        }
+        ++position;
+    }
+
+    try {
+        bool busy = IsWorkspaceBusy();
+        std::vector<std::string> functions;
+        std::string functionPrefix;
+        size_t functionTotal = 0;
+        if (busy || IsFileExists(DEFINITIONS_FILE_PATH)) {
+            FunctionCompletions& known = busy ? LastFunctionCompletions() : SyncFunctionCompletions();
+            functionTotal = known.stubs.Match(word, limit, functions, functionPrefix);
+            if (functionTotal == 0) {
+                functionTotal = known.all.Match(word, limit, functions, functionPrefix);
+            }
+        }
+        if (position == 0) {
+            result.total = functionTotal;
+            result.candidates = std::move(functions);
+            result.commonPrefix = std::move(functionPrefix);
+            return result;
+        }
+
+        std::vector<std::string> components;
+        for (const auto& component : ComponentCompletions(busy)) {
+            if (!std::string_view(component).starts_with(word)) continue;
+            result.commonPrefix = result.total == 0 ? component : std::string(CommonPrefix(result.commonPrefix, component));
+            ++result.total;
+            if (components.size() < limit) components.push_back(component);
+        }
+        if (functionTotal != 0) {
+            result.commonPrefix = result.total == 0 ? functionPrefix : std::string(CommonPrefix(result.commonPrefix, functionPrefix));
+            result.total += functionTotal;
+        }
+        // Both lists are sorted and hold the first 'limit' of their matches.
+        std::merge(functions.begin(), functions.end(), components.begin(), components.end(), std::back_inserter(result.candidates));
+        if (result.candidates.size() > limit) result.candidates.resize(limit);
+    }
+    catch (const std::exception&) {
+        // Completion is best-effort; a broken workspace just offers nothing.
+    }
+    return result;
+}
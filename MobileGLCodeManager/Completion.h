@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Sorted set of names with prefix lookup. The characters live in one pool and
+// the set itself is an array of offsets, so 10k names cost two allocations and
+// a lookup is two binary searches.
+class CompletionIndex {
+public:
+    // Replaces the contents; duplicates are dropped. Already sorted input is not re-sorted.
+    void Assign(const std::vector<std::string_view>& names);
+
+    // Returns how many names start with 'prefix', appends up to 'limit' of them
+    // to 'out' in sorted order, and extends 'commonPrefix' to the longest prefix
+    // they all share.
+    size_t Match(std::string_view prefix, size_t limit, std::vector<std::string>& out, std::string& commonPrefix) const;
+    size_t Size() const { return offsets.size(); }
+
+private:
+    std::string_view At(size_t i) const;
+
+    std::string pool;              // "name\0name\0..."
+    std::vector<uint32_t> offsets; // into pool, sorted by name
+};
+
+struct CompletionResult {
+    size_t wordStart = 0;               // where the completed word begins
+    std::vector<std::string> candidates; // sorted, at most the requested limit
+    size_t total = 0;                    // number of matches
+    std::string commonPrefix;            // longest prefix shared by all matches
+    bool spaceAfterUnique = true;        // false when the only match is a directory to descend into
+};
+
+// Completes the word that ends at 'cursor' in an interactive command line:
+// command names; for the arguments of "impl", GL functions (stubbed ones first,
+// all if none match) together with component directories, since any of them can
+// be the component; and file paths after "impl -f".
+CompletionResult CompleteCommandLine(const std::string& line, size_t cursor, size_t limit);
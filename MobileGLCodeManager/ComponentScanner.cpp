@@ -0,0 +1,147 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "ComponentScanner.h"
+#include "CMD_implementFunction.h"
+#include "DefinitionScanner.h"
+#include "FileUtils.h"
+
+namespace fs = std::filesystem;
+
+static bool IsIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Parses "<ret> <name>(<params>)" at the start of a trimmed line. On success,
+// 'rest' holds the text after the closing parenthesis.
+static bool ParseFunctionHead(std::string_view line, ComponentSymbol& symbol, std::string_view& rest) {
+    if (line.empty() || line[0] == '#' || line.starts_with("//") || line.starts_with("/*")) return false;
+
+    size_t open = line.find('(');
+    if (open == std::string_view::npos) return false;
+
+    size_t nameEnd = open;
+    while (nameEnd > 0 && (line[nameEnd - 1] == ' ' || line[nameEnd - 1] == '\t')) --nameEnd;
+    size_t nameBegin = nameEnd;
+    while (nameBegin > 0 && IsIdentifierChar(line[nameBegin - 1])) --nameBegin;
+    if (nameBegin == nameEnd || (line[nameBegin] >= '0' && line[nameBegin] <= '9')) return false;
+
+    std::string_view returnType = TrimWhitespace(line.substr(0, nameBegin));
+    if (returnType.empty() || returnType.find_first_of("=(){};,") != std::string_view::npos) return false;
+    for (std::string_view keyword : { "return", "else", "case", "delete", "new", "throw", "goto" }) {
+        if (returnType == keyword || returnType.starts_with(std::string(keyword) + " ")) return false;
+    }
+
+    int depth = 0;
+    size_t close = open;
+    for (; close < line.size(); ++close) {
+        if (line[close] == '(') ++depth;
+        else if (line[close] == ')' && --depth == 0) break;
+    }
+    if (close >= line.size()) return false;
+
+    symbol.name = line.substr(nameBegin, nameEnd - nameBegin);
+    symbol.returnType = returnType;
+    symbol.params = TrimWhitespace(line.substr(open + 1, close - open - 1));
+    rest = TrimWhitespace(line.substr(close + 1));
+    return true;
+}
+
+template <typename LineHandler>
+static void ForEachLine(std::string_view text, LineHandler&& handler) {
+    size_t lineStart = 0;
+    size_t lineNumber = 1;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+        handler(text.substr(lineStart, lineEnd - lineStart), lineNumber);
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+    }
+}
+
+std::vector<ComponentSymbol> ScanComponentDeclarations(std::string_view header) {
+    std::vector<ComponentSymbol> symbols;
+    ForEachLine(header, [&](std::string_view line, size_t lineNumber) {
+        ComponentSymbol symbol;
+        std::string_view rest;
+        if (ParseFunctionHead(TrimWhitespace(line), symbol, rest) && rest.ends_with(';') &&
+            rest.find_first_of("{=") == std::string_view::npos) {
+            symbol.line = lineNumber;
+            symbols.push_back(symbol);
+        }
+    });
+    return symbols;
+}
+
+std::vector<ComponentSymbol> ScanComponentDefinitions(std::string_view source) {
+    std::vector<ComponentSymbol> symbols;
+    int bodyDepth = 0;
+    bool pendingBody = false; // a definition whose '{' is on a following line
+    ForEachLine(source, [&](std::string_view rawLine, size_t lineNumber) {
+        std::string_view line = TrimWhitespace(rawLine);
+        if (bodyDepth == 0 && !pendingBody) {
+            ComponentSymbol symbol;
+            std::string_view rest;
+            if (!ParseFunctionHead(line, symbol, rest)) return;
+            if (rest.empty()) {
+                pendingBody = true;
+            } else if (!rest.starts_with('{') && !rest.ends_with('{')) {
+                return;
+            }
+            symbol.line = lineNumber;
+            symbols.push_back(symbol);
+            if (pendingBody) return;
+        } else if (pendingBody) {
+            if (line.empty()) return;
+            pendingBody = false;
+            if (!line.starts_with('{')) {
+                symbols.pop_back();
+                return;
+            }
+        }
+        bodyDepth += static_cast<int>(std::count(line.begin(), line.end(), '{'));
+        bodyDepth -= static_cast<int>(std::count(line.begin(), line.end(), '}'));
+        bodyDepth = std::max(bodyDepth, 0);
+    });
+    if (pendingBody) symbols.pop_back();
+    return symbols;
+}
+
+std::string ComponentHeaderPath(const std::string& component) {
+    return std::string(GL_IMPL_DIRECTORY_PATH) + "/" + component + "/GL_" + component + ".h";
+}
+
+std::string ComponentSourcePath(const std::string& component) {
+    return std::string(GL_IMPL_DIRECTORY_PATH) + "/" + component + "/GL_" + component + ".cpp";
+}
+
+std::vector<std::string> ListComponents() {
+    std::vector<std::string> candidates;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(GL_IMPL_DIRECTORY_PATH, ec)) {
+        if (!entry.is_directory()) continue;
+        candidates.push_back(entry.path().filename().string());
+    }
+    // Components created while staging only exist in memory so far.
+    fs::path implDir = fs::path(GL_IMPL_DIRECTORY_PATH).lexically_normal();
+    for (const auto& file : GetStagedFiles()) {
+        fs::path componentDir = fs::path(file.path).parent_path();
+        if (componentDir.parent_path() == implDir) {
+            candidates.push_back(componentDir.filename().string());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::string> components;
+    for (auto& name : candidates) {
+        if (IsFileExists(ComponentHeaderPath(name)) || IsFileExists(ComponentSourcePath(name))) {
+            components.push_back(std::move(name));
+        }
+    }
+    return components;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A function declared in GL_<component>.h or defined in GL_<component>.cpp.
+// The views point into the scanned text.
+struct ComponentSymbol {
+    std::string_view name;
+    std::string_view returnType;
+    std::string_view params;
+    size_t line = 0; // 1-based
+};
+
+// Finds function declarations ("<ret> <name>(<params>);") in a component header.
+std::vector<ComponentSymbol> ScanComponentDeclarations(std::string_view header);
+
+// Finds function definitions ("<ret> <name>(<params>) {") in a component source.
+// Function bodies are skipped, so calls inside them are never reported.
+std::vector<ComponentSymbol> ScanComponentDefinitions(std::string_view source);
+
+// Names of the directories under GL_IMPL_DIRECTORY_PATH that contain a
+// GL_<name>.h or GL_<name>.cpp, sorted.
+std::vector<std::string> ListComponents();
+
+std::string ComponentHeaderPath(const std::string& component);
+std::string ComponentSourcePath(const std::string& component);
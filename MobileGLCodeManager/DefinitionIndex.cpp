@@ -0,0 +1,261 @@
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <filesystem>
+#include <mutex>
+
+#include "DefinitionIndex.h"
+#include "DefinitionScanner.h"
+#include "FileUtils.h"
+#include "FileWatcher.h"
+#include "Instrumentation.h"
+#include "WorkspaceCache.h"
+
+namespace fs = std::filesystem;
+
+static const char* MACRO_PREFIX = "DECLARE_GL_FUNCTION_";
+static const char* STUB_INFIX = "STUB_";
+
+void DefinitionIndex::Build(std::string newContent) {
+    ScopedTimer timer("DefinitionIndex::Build");
+    content = std::move(newContent);
+    entries.clear();
+    entryByName.clear();
+    ++generation;
+
+    DefinitionScanner scanner(content);
+    GLMacroToken token;
+    GLMacroToken head;
+    size_t headLine = 0;
+    bool hasHead = false;
+
+    while (scanner.Next(token)) {
+        if (token.kind == GLMacroKind::Head) {
+            head = token;
+            headLine = scanner.Line();
+            hasHead = true;
+            continue;
+        }
+        if (!hasHead) continue;
+        hasHead = false;
+
+        std::vector<std::string_view> parts = SplitMacroArguments(head.args);
+        if (parts.size() < 2) continue;
+
+        DefinitionEntry entry;
+        entry.returnType = parts[0];
+        entry.name = parts[1];
+        entry.params.assign(parts.begin() + 2, parts.end());
+        entry.firstLine = headLine;
+        entry.lastLine = scanner.Line();
+        entry.headOffset = head.offset;
+        entry.endOffset = token.offset;
+        entry.isStub = head.isStub;
+
+        entryByName.emplace(entry.name, entries.size());
+        entries.push_back(std::move(entry));
+    }
+}
+
+void DefinitionIndex::Adopt(DefinitionIndex& other) {
+    // The entries point into other.content. A moved std::string keeps its buffer,
+    // except for short strings stored inline, which have to be re-parsed.
+    const char* oldData = other.content.data();
+    content = std::move(other.content);
+    other.content.clear();
+    if (content.data() != oldData) {
+        other.entries.clear();
+        other.entryByName.clear();
+        Build(std::move(content));
+        return;
+    }
+    entries = std::move(other.entries);
+    entryByName = std::move(other.entryByName);
+    other.entries.clear();
+    other.entryByName.clear();
+    ++generation;
+}
+
+void DefinitionIndex::Restore(std::string newContent, std::vector<DefinitionEntry> newEntries) {
+    ScopedTimer timer("DefinitionIndex::Restore");
+    const char* oldData = newContent.data();
+    content = std::move(newContent);
+    entries = std::move(newEntries);
+    entryByName.clear();
+    ++generation;
+
+    // Short strings move their characters, so the views follow them.
+    auto rebase = [&](std::string_view& view) {
+        if (content.data() != oldData) view = std::string_view(content.data() + (view.data() - oldData), view.size());
+    };
+    entryByName.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        DefinitionEntry& entry = entries[i];
+        rebase(entry.name);
+        rebase(entry.returnType);
+        for (auto& param : entry.params) rebase(param);
+        entryByName.emplace(entry.name, i);
+    }
+}
+
+const DefinitionEntry* DefinitionIndex::Find(std::string_view name) const {
+    auto it = entryByName.find(name);
+    return it == entryByName.end() ? nullptr : &entries[it->second];
+}
+
+struct FileStamp {
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+    uint64_t stagedVersion = 0;
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+static FileStamp GetFileStamp(const std::string& filename) {
+    FileStamp stamp;
+    stamp.stagedVersion = GetStagedVersion(filename);
+    if (stamp.stagedVersion != 0) {
+        // Staged files may not exist on disk yet; the version alone identifies them.
+        return stamp;
+    }
+    stamp.size = fs::file_size(filename);
+    stamp.mtime = fs::last_write_time(filename);
+    return stamp;
+}
+
+struct CachedDefinitionIndex {
+    DefinitionIndex index;
+    FileStamp stamp;
+    uint64_t watchVersion = 0; // 0 unless the watcher vouched for 'stamp'
+    bool valid = false;
+};
+
+static std::unordered_map<std::string, std::unique_ptr<CachedDefinitionIndex>> definitionIndexCache;
+
+// Indexes parsed by PrewarmDefinitionIndex, plus the stamp each cached index was
+// built from, so the watcher thread can skip files the cache already reflects.
+struct PrewarmedIndex {
+    std::unique_ptr<DefinitionIndex> index;
+    FileStamp stamp;
+};
+static std::mutex prewarmMutex;
+static std::unordered_map<std::string, PrewarmedIndex> prewarmedIndexes;
+static std::unordered_map<std::string, FileStamp> cachedStamps;
+
+static CachedDefinitionIndex& GetCacheSlot(const std::string& filename) {
+    auto& slot = definitionIndexCache[filename];
+    if (!slot) slot = std::make_unique<CachedDefinitionIndex>();
+    return *slot;
+}
+
+static void SetCachedStamp(const std::string& filename, CachedDefinitionIndex& cached, const FileStamp& stamp) {
+    cached.stamp = stamp;
+    cached.valid = true;
+    std::lock_guard<std::mutex> lock(prewarmMutex);
+    cachedStamps[filename] = stamp;
+    prewarmedIndexes.erase(filename);
+}
+
+const DefinitionIndex& GetDefinitionIndex(const std::string& filename) {
+    CachedDefinitionIndex& cached = GetCacheSlot(filename);
+
+    uint64_t watchVersion = 0;
+    bool watched = GetStagedVersion(filename) == 0 && GetWatchedFileVersion(filename, watchVersion);
+    if (watched && cached.valid && cached.watchVersion == watchVersion && cached.stamp.stagedVersion == 0) {
+        return cached.index;
+    }
+
+    FileStamp stamp = GetFileStamp(filename);
+    if (!cached.valid || !(cached.stamp == stamp)) {
+        std::unique_ptr<DefinitionIndex> prewarmed;
+        {
+            std::lock_guard<std::mutex> lock(prewarmMutex);
+            auto it = prewarmedIndexes.find(filename);
+            if (it != prewarmedIndexes.end() && it->second.stamp == stamp) prewarmed = std::move(it->second.index);
+        }
+        if (prewarmed) {
+            cached.index.Adopt(*prewarmed);
+            StoreDefinitions(filename, &cached.index);
+        } else {
+            std::string content = GetFileContent(filename);
+            CacheStamp cacheStamp{ true, static_cast<uint64_t>(stamp.size), stamp.mtime.time_since_epoch().count() };
+            if (stamp.stagedVersion != 0 || !LoadCachedDefinitions(filename, cacheStamp, content, cached.index)) {
+                cached.index.Build(std::move(content));
+                StoreDefinitions(filename, &cached.index);
+            }
+        }
+        SetCachedStamp(filename, cached, stamp);
+    }
+    cached.watchVersion = watched ? watchVersion : 0;
+    return cached.index;
+}
+
+void UpdateDefinitionIndex(const std::string& filename, std::string content) {
+    DefinitionIndex updated;
+    updated.Build(std::move(content));
+    UpdateDefinitionIndex(filename, updated);
+}
+
+void UpdateDefinitionIndex(const std::string& filename, DefinitionIndex& updated) {
+    CachedDefinitionIndex& cached = GetCacheSlot(filename);
+    cached.index.Adopt(updated);
+    StoreDefinitions(filename, &cached.index);
+    cached.watchVersion = 0;
+    SetCachedStamp(filename, cached, GetFileStamp(filename));
+}
+
+void PrewarmDefinitionIndex(const std::string& filename) {
+    ScopedTimer timer("PrewarmDefinitionIndex");
+    try {
+        FileStamp stamp = GetFileStamp(filename);
+        {
+            std::lock_guard<std::mutex> lock(prewarmMutex);
+            auto cachedIt = cachedStamps.find(filename);
+            if (cachedIt != cachedStamps.end() && cachedIt->second == stamp) return;
+            auto it = prewarmedIndexes.find(filename);
+            if (it != prewarmedIndexes.end() && it->second.stamp == stamp) return;
+        }
+
+        auto index = std::make_unique<DefinitionIndex>();
+        index->Build(ReadFileFromDisk(filename));
+        // Discard the result if the file changed while it was being read.
+        if (!(GetFileStamp(filename) == stamp)) return;
+
+        std::lock_guard<std::mutex> lock(prewarmMutex);
+        prewarmedIndexes[filename] = PrewarmedIndex{ std::move(index), stamp };
+    }
+    catch (const std::exception&) {
+        // The file may be mid-replacement; the next lookup reads it on demand.
+    }
+}
+
+static bool SetMacroStub(std::string& content, size_t offset, bool is_stub) {
+    size_t infixPos = offset + strlen(MACRO_PREFIX);
+    bool hasStub = content.compare(infixPos, strlen(STUB_INFIX), STUB_INFIX) == 0;
+    if (hasStub == is_stub) return false;
+    if (is_stub) {
+        content.insert(infixPos, STUB_INFIX);
+    } else {
+        content.erase(infixPos, strlen(STUB_INFIX));
+    }
+    return true;
+}
+
+bool SetFunctionStubsInContent(std::string& content, std::vector<const DefinitionEntry*> entries, bool is_stub) {
+    // Edit back to front so the offsets of the remaining entries stay valid.
+    std::sort(entries.begin(), entries.end(), [](const DefinitionEntry* a, const DefinitionEntry* b) {
+        return a->headOffset > b->headOffset;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    bool changed = false;
+    for (const DefinitionEntry* entry : entries) {
+        changed |= SetMacroStub(content, entry->endOffset, is_stub);
+        changed |= SetMacroStub(content, entry->headOffset, is_stub);
+    }
+    return changed;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+// One DECLARE_GL_FUNCTION_(STUB_)HEAD ... DECLARE_GL_FUNCTION_(STUB_)END pair.
+// The string views point into the content owned by the index.
+struct DefinitionEntry {
+    std::string_view name;
+    std::string_view returnType;
+    std::vector<std::string_view> params;
+    size_t firstLine = 0; // 1-based line of the HEAD macro
+    size_t lastLine = 0;  // 1-based line of the END macro
+    size_t headOffset = 0; // byte offset of the HEAD macro name
+    size_t endOffset = 0;  // byte offset of the END macro name
+    bool isStub = false;
+};
+
+class DefinitionIndex {
+public:
+    DefinitionIndex() = default;
+    DefinitionIndex(const DefinitionIndex&) = delete;
+    DefinitionIndex& operator=(const DefinitionIndex&) = delete;
+
+    void Build(std::string content);
+    // Takes over the content and entries of 'other', leaving it empty.
+    void Adopt(DefinitionIndex& other);
+    // Takes entries that were parsed from 'content' earlier (see WorkspaceCache.h)
+    // instead of parsing it again. Their views may point into 'content'.
+    void Restore(std::string content, std::vector<DefinitionEntry> entries);
+
+    const DefinitionEntry* Find(std::string_view name) const;
+    const std::vector<DefinitionEntry>& Entries() const { return entries; }
+    const std::string& Content() const { return content; }
+
+    // Bumped on every rebuild so dependent caches can tell when to refresh.
+    size_t Generation() const { return generation; }
+
+private:
+    std::string content;
+    std::vector<DefinitionEntry> entries;
+    std::unordered_map<std::string_view, size_t> entryByName;
+    size_t generation = 0;
+};
+
+// Session-wide index of a definitions file. It is parsed on first use and rebuilt
+// only when the file's size or modification time changes. While the file watcher
+// covers the file, an unchanged file is not even stat'ed.
+const DefinitionIndex& GetDefinitionIndex(const std::string& filename);
+
+// Parses the current file content ahead of time, typically on the file watcher
+// thread. The next GetDefinitionIndex picks the result up if the file is still
+// the same. Does nothing if the cached index is already current.
+void PrewarmDefinitionIndex(const std::string& filename);
+
+// Replaces the cached index with freshly written content, so our own writes do
+// not force a re-read on the next lookup.
+void UpdateDefinitionIndex(const std::string& filename, std::string content);
+// Same, taking over an index already built from the written content.
+void UpdateDefinitionIndex(const std::string& filename, DefinitionIndex& updated);
+
+// Flips the HEAD/END macros of the given entries between their STUB_ and regular
+// forms. The entries must belong to an index built from 'content'.
+bool SetFunctionStubsInContent(std::string& content, std::vector<const DefinitionEntry*> entries, bool is_stub);
@@ -0,0 +1,102 @@
+#include <string_view>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "DefinitionScanner.h"
+
+static constexpr std::string_view MACRO_PREFIX = "DECLARE_GL_FUNCTION_";
+static constexpr std::string_view STUB_INFIX = "STUB_";
+
+static bool IsIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static bool IsWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool DefinitionScanner::Next(GLMacroToken& token) {
+    const char* data = text.data();
+    const size_t size = text.size();
+
+    while (pos + MACRO_PREFIX.size() <= size) {
+        const void* hit = memchr(data + pos, MACRO_PREFIX[0], size - MACRO_PREFIX.size() + 1 - pos);
+        if (!hit) break;
+
+        size_t start = static_cast<const char*>(hit) - data;
+        pos = start + 1;
+        if (memcmp(data + start, MACRO_PREFIX.data(), MACRO_PREFIX.size()) != 0) continue;
+        if (start > 0 && IsIdentifierChar(data[start - 1])) continue;
+
+        size_t cursor = start + MACRO_PREFIX.size();
+        size_t nameEnd = cursor;
+        while (nameEnd < size && IsIdentifierChar(data[nameEnd])) ++nameEnd;
+        std::string_view suffix = text.substr(cursor, nameEnd - cursor);
+
+        bool isStub = suffix.starts_with(STUB_INFIX);
+        if (isStub) suffix.remove_prefix(STUB_INFIX.size());
+
+        GLMacroKind kind;
+        if (suffix == "HEAD") kind = GLMacroKind::Head;
+        else if (suffix == "END") kind = GLMacroKind::End;
+        else if (suffix == "END_NO_RETURN") kind = GLMacroKind::EndNoReturn;
+        else continue;
+
+        cursor = nameEnd;
+        while (cursor < size && IsWhitespace(data[cursor])) ++cursor;
+        if (cursor >= size || data[cursor] != '(') continue;
+
+        size_t argsBegin = cursor + 1;
+        int depth = 1;
+        for (++cursor; cursor < size && depth > 0; ++cursor) {
+            if (data[cursor] == '(') ++depth;
+            else if (data[cursor] == ')') --depth;
+        }
+        if (depth != 0) break;
+
+        line += std::count(data + lineCountedUpTo, data + start, '\n');
+        lineCountedUpTo = start;
+
+        token.kind = kind;
+        token.isStub = isStub;
+        token.offset = start;
+        token.args = text.substr(argsBegin, cursor - 1 - argsBegin);
+        pos = cursor;
+        return true;
+    }
+
+    pos = size;
+    return false;
+}
+
+std::string_view TrimWhitespace(std::string_view text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && IsWhitespace(text[begin])) ++begin;
+    while (end > begin && IsWhitespace(text[end - 1])) --end;
+    return text.substr(begin, end - begin);
+}
+
+std::vector<std::string_view> SplitMacroArguments(std::string_view args) {
+    std::vector<std::string_view> parts;
+    size_t partStart = 0;
+    int depth = 0;
+    for (size_t i = 0; i < args.size(); ++i) {
+        switch (args[i]) {
+        case '(': case '[': case '{': case '<':
+            ++depth;
+            break;
+        case ')': case ']': case '}': case '>':
+            if (depth > 0) --depth;
+            break;
+        case ',':
+            if (depth != 0) break;
+            parts.push_back(TrimWhitespace(args.substr(partStart, i - partStart)));
+            partStart = i + 1;
+            break;
+        }
+    }
+    parts.push_back(TrimWhitespace(args.substr(partStart)));
+    return parts;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+enum class GLMacroKind {
+    Head,        // DECLARE_GL_FUNCTION_(STUB_)HEAD
+    End,         // DECLARE_GL_FUNCTION_(STUB_)END
+    EndNoReturn, // DECLARE_GL_FUNCTION_(STUB_)END_NO_RETURN
+};
+
+struct GLMacroToken {
+    GLMacroKind kind = GLMacroKind::Head;
+    bool isStub = false;
+    size_t offset = 0;      // byte offset of "DECLARE_GL_FUNCTION_"
+    std::string_view args;  // text between the macro's parentheses
+};
+
+// Single-pass tokenizer for the DECLARE_GL_FUNCTION_* macro family. Macro heads
+// are located with memchr, and arguments are matched with balanced parentheses.
+class DefinitionScanner {
+public:
+    explicit DefinitionScanner(std::string_view text) : text(text) {}
+
+    // Advances to the next macro invocation. Returns false at the end of the text.
+    bool Next(GLMacroToken& token);
+
+    // Number of '\n' characters before the last returned token, plus one.
+    size_t Line() const { return line; }
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+    size_t line = 1;
+    size_t lineCountedUpTo = 0;
+};
+
+std::string_view TrimWhitespace(std::string_view text);
+
+// Splits macro arguments on top-level ',' and trims each part. Commas inside
+// (), [], {} or <> belong to one argument, e.g. a function pointer parameter type.
+std::vector<std::string_view> SplitMacroArguments(std::string_view args);
@@ -0,0 +1,334 @@
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "FileUtils.h"
+#include "FileWatcher.h"
+#include "Instrumentation.h"
+
+namespace fs = std::filesystem;
+
+struct StagedEntry {
+    std::string content;
+    uint64_t version = 0;
+};
+
+// Keyed by normalized path so different spellings of one file share an entry.
+// Workers of a parallel impl read and write concurrently, hence the mutex.
+static std::mutex stagingMutex;
+static bool stagingEnabled = false;
+static uint64_t stagingVersionCounter = 0;
+static std::map<std::string, StagedEntry> stagedFiles;
+
+static std::string StagingKey(const std::string& filename) {
+    return fs::path(filename).lexically_normal().generic_string();
+}
+
+// Contents of watched files. An entry is served as long as the file watcher
+// reports the version it was stored with; after our own writes, whose events
+// arrive later, a matching size and mtime revalidate it.
+struct CachedContent {
+    std::string content;
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+    uint64_t watchVersion = 0;
+};
+
+static std::mutex contentCacheMutex;
+static std::unordered_map<std::string, CachedContent> contentCache;
+
+static bool GetContentStamp(const std::string& filename, CachedContent& stamp) {
+    std::error_code ec;
+    stamp.size = fs::file_size(filename, ec);
+    if (ec) return false;
+    stamp.mtime = fs::last_write_time(filename, ec);
+    return !ec;
+}
+
+static bool FindCachedContent(const std::string& key, uint64_t watchVersion, std::string& content) {
+    std::lock_guard<std::mutex> lock(contentCacheMutex);
+    auto it = contentCache.find(key);
+    if (it == contentCache.end()) return false;
+
+    CachedContent& cached = it->second;
+    if (cached.watchVersion != watchVersion) {
+        CachedContent current;
+        if (!GetContentStamp(key, current) || current.size != cached.size || current.mtime != cached.mtime) {
+            return false;
+        }
+        cached.watchVersion = watchVersion;
+    }
+    content = cached.content;
+    return true;
+}
+
+// 'stamp' must be taken before the content was read, so a concurrent change
+// leaves an entry that no longer validates.
+static void StoreCachedContent(const std::string& key, CachedContent stamp, const std::string& content) {
+    if (stamp.size != content.size()) return;
+    stamp.content = content;
+    std::lock_guard<std::mutex> lock(contentCacheMutex);
+    contentCache[key] = std::move(stamp);
+}
+
+bool IsFileExists(const std::string& pathStr) {
+    {
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        if (!stagedFiles.empty() && stagedFiles.contains(StagingKey(pathStr))) return true;
+    }
+    fs::path filePath(pathStr);
+    return fs::exists(filePath) && fs::is_regular_file(filePath);
+}
+
+std::string GetFileContent(const std::string& filename) {
+    ScopedTimer timer("GetFileContent");
+    {
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        if (!stagedFiles.empty()) {
+            auto it = stagedFiles.find(StagingKey(filename));
+            if (it != stagedFiles.end()) return it->second.content;
+        }
+    }
+
+    uint64_t watchVersion = 0;
+    if (!GetWatchedFileVersion(filename, watchVersion)) {
+        return ReadFileFromDisk(filename);
+    }
+    std::string key = StagingKey(filename);
+    std::string content;
+    if (FindCachedContent(key, watchVersion, content)) {
+        return content;
+    }
+    CachedContent stamp;
+    bool hasStamp = GetContentStamp(key, stamp);
+    content = ReadFileFromDisk(filename);
+    if (hasStamp) {
+        stamp.watchVersion = watchVersion;
+        StoreCachedContent(key, std::move(stamp), content);
+    }
+    return content;
+}
+
+std::string ReadFileFromDisk(const std::string& filename) {
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+
+    // Size the buffer once and read the whole file in a single call. The bytes are
+    // kept as-is, including the original line endings.
+    std::error_code ec;
+    uintmax_t size = fs::file_size(filename, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot read file size: " + filename);
+    }
+
+    std::string content(static_cast<size_t>(size), '\0');
+    if (!inFile.read(content.data(), static_cast<std::streamsize>(content.size()))) {
+        content.resize(static_cast<size_t>(inFile.gcount()));
+    }
+    inFile.close();
+    RecordFileRead(content.size());
+    return content;
+}
+
+std::string_view DetectNewline(std::string_view content) {
+    size_t pos = content.find('\n');
+    if (pos != std::string_view::npos && pos > 0 && content[pos - 1] == '\r') {
+        return "\r\n";
+    }
+    return "\n";
+}
+
+static bool HasSameContent(const std::string& filename, const std::string& content) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(filename, ec);
+    if (ec || size != content.size()) {
+        return false;
+    }
+
+    std::ifstream inFile(filename, std::ios::binary);
+    if (!inFile.is_open()) {
+        return false;
+    }
+
+    // Compare in chunks so large files are not buffered twice.
+    char buffer[64 * 1024];
+    size_t offset = 0;
+    while (offset < content.size()) {
+        size_t chunk = std::min(sizeof(buffer), content.size() - offset);
+        if (!inFile.read(buffer, static_cast<std::streamsize>(chunk))) {
+            return false;
+        }
+        if (memcmp(buffer, content.data() + offset, chunk) != 0) {
+            return false;
+        }
+        offset += chunk;
+    }
+    RecordFileRead(content.size());
+    return true;
+}
+
+bool WriteToFile(const std::string& filename, const std::string& content) {
+    {
+        std::unique_lock<std::mutex> lock(stagingMutex);
+        if (stagingEnabled) {
+            ScopedTimer timer("StageFile");
+            std::string key = StagingKey(filename);
+            auto it = stagedFiles.find(key);
+            if (it != stagedFiles.end()) {
+                if (it->second.content == content) return false;
+                it->second.content = content;
+                it->second.version = ++stagingVersionCounter;
+                return true;
+            }
+            // The disk is compared without the lock. Another writer may stage this
+            // file meanwhile, so its entry is looked up again: the later write wins,
+            // even if it matches the disk.
+            lock.unlock();
+            bool sameAsDisk = HasSameContent(filename, content);
+            lock.lock();
+            if (stagingEnabled) {
+                it = stagedFiles.find(key);
+                if (it != stagedFiles.end()) {
+                    if (it->second.content == content) return false;
+                    it->second.content = content;
+                    it->second.version = ++stagingVersionCounter;
+                    return true;
+                }
+                if (sameAsDisk) return false;
+                stagedFiles.emplace(key, StagedEntry{ content, ++stagingVersionCounter });
+                return true;
+            }
+        }
+    }
+    return WriteFileToDisk(filename, content);
+}
+
+bool WriteFileToDisk(const std::string& filename, const std::string& content) {
+    ScopedTimer timer("WriteToFile");
+
+    // Leave files whose content is unchanged alone, so their mtime does not
+    // trigger a rebuild of everything that includes them.
+    if (HasSameContent(filename, content)) {
+        return false;
+    }
+
+    fs::path filePath(filename);
+    fs::path dirPath = filePath.parent_path();
+    std::error_code ec;
+    if (!dirPath.empty() && !fs::exists(dirPath, ec)) {
+        ScopedTimer dirTimer("CreateDirectories");
+        fs::create_directories(dirPath, ec);
+        if (ec) {
+            throw std::runtime_error("Failed to create directories: " + dirPath.string());
+        }
+    }
+
+    // Write to a temporary file next to the target and rename it over the target,
+    // so an interrupted run never leaves a half-written file behind. The name is
+    // unique per process and write, so a serve daemon and a CLI run writing the
+    // same file never share a temporary file; the last rename wins.
+    static std::atomic<uint64_t> tempCounter{ 0 };
+#ifdef _WIN32
+    long long processId = _getpid();
+#else
+    long long processId = getpid();
+#endif
+    fs::path tempPath = filePath;
+    tempPath += ".mgcm-tmp." + std::to_string(processId) + "." + std::to_string(tempCounter++);
+
+    std::ofstream outFile(tempPath, std::ios::binary | std::ios::trunc);
+    if (!outFile.is_open()) {
+        throw std::runtime_error("Cannot write to file: " + filename);
+    }
+    outFile.write(content.data(), static_cast<std::streamsize>(content.size()));
+    outFile.close();
+    if (!outFile) {
+        fs::remove(tempPath, ec);
+        throw std::runtime_error("Cannot write to file: " + filename);
+    }
+
+    fs::file_status status = fs::status(filePath, ec);
+    if (!ec && fs::exists(status)) {
+        fs::permissions(tempPath, status.permissions(), ec);
+    }
+
+    fs::rename(tempPath, filePath, ec);
+    if (ec) {
+        fs::remove(tempPath, ec);
+        throw std::runtime_error("Cannot replace file: " + filename);
+    }
+    RecordFileWrite(content.size());
+
+    uint64_t watchVersion = 0;
+    CachedContent stamp;
+    if (GetWatchedFileVersion(filename, watchVersion) && GetContentStamp(filename, stamp)) {
+        // Version 0 never matches, so the next read checks size and mtime first.
+        StoreCachedContent(StagingKey(filename), std::move(stamp), content);
+    }
+    return true;
+}
+
+void SetStagingEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    stagingEnabled = enabled;
+}
+
+bool IsStagingEnabled() {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    return stagingEnabled;
+}
+
+bool HasStagedFiles() {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    return !stagedFiles.empty();
+}
+
+std::vector<StagedFile> GetStagedFiles() {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    std::vector<StagedFile> files;
+    files.reserve(stagedFiles.size());
+    for (const auto& [path, entry] : stagedFiles) {
+        files.push_back(StagedFile{ path, entry.content });
+    }
+    return files;
+}
+
+uint64_t GetStagedVersion(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    if (stagedFiles.empty()) return 0;
+    auto it = stagedFiles.find(StagingKey(filename));
+    return it == stagedFiles.end() ? 0 : it->second.version;
+}
+
+size_t CommitStagedFiles() {
+    ScopedTimer timer("CommitStagedFiles");
+    size_t written = 0;
+    for (const auto& file : GetStagedFiles()) {
+        if (WriteFileToDisk(file.path, file.content)) ++written;
+        std::lock_guard<std::mutex> lock(stagingMutex);
+        stagedFiles.erase(file.path);
+    }
+    return written;
+}
+
+size_t DiscardStagedFiles() {
+    std::lock_guard<std::mutex> lock(stagingMutex);
+    size_t count = stagedFiles.size();
+    stagedFiles.clear();
+    return count;
+}
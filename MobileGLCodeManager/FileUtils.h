@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+bool IsFileExists(const std::string& pathStr);
+// Reads the whole file with a single sized read, preserving its bytes exactly.
+std::string GetFileContent(const std::string& filename);
+// Same as GetFileContent, but ignores staged content.
+std::string ReadFileFromDisk(const std::string& filename);
+// Returns "\r\n" if the content uses CRLF line endings, "\n" otherwise.
+std::string_view DetectNewline(std::string_view content);
+// Writes the content atomically (temporary file + rename), creating missing
+// directories. Returns false without touching the file if it already holds
+// exactly this content. While staging is enabled the content is only staged.
+bool WriteToFile(const std::string& filename, const std::string& content);
+// Same as WriteToFile, but always goes to disk, bypassing staging.
+bool WriteFileToDisk(const std::string& filename, const std::string& content);
+
+// --- staging ---
+// While staging is enabled, WriteToFile keeps file contents in an in-memory
+// write-back cache, and IsFileExists/GetFileContent see the staged versions.
+// CommitStagedFiles then writes every dirty file exactly once.
+struct StagedFile {
+    std::string path;
+    std::string content;
+};
+
+void SetStagingEnabled(bool enabled);
+bool IsStagingEnabled();
+bool HasStagedFiles();
+// Sorted by path.
+std::vector<StagedFile> GetStagedFiles();
+// Changes whenever the staged content of the file changes; 0 if it is not staged.
+uint64_t GetStagedVersion(const std::string& filename);
+// Writes all staged files to disk and returns how many were written. Files that
+// were written are unstaged even if a later one fails.
+size_t CommitStagedFiles();
+// Drops all staged changes and returns how many files were staged.
+size_t DiscardStagedFiles();
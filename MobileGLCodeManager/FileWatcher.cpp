@@ -0,0 +1,323 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include "FileWatcher.h"
+#include "CMD_implementFunction.h"
+#include "DefinitionIndex.h"
+#include "Instrumentation.h"
+
+namespace fs = std::filesystem;
+
+enum class WatcherMode { Off, Inotify, Polling };
+
+static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(1000);
+
+static std::mutex watcherMutex;
+static std::thread watcherThread;
+static std::atomic<bool> watcherStopping{ false };
+static WatcherMode watcherMode = WatcherMode::Off;
+
+static std::string watchedRoot;      // normalized directory
+static std::string watchedExtraFile; // normalized file
+static bool watchIntact = false;     // false once a watched root went away
+
+// A file's version is (epoch << 32) + its change counter. The epoch moves on
+// every start and whenever changes can no longer be attributed to single files,
+// so versions handed out earlier never match again.
+static uint64_t watcherEpoch = 0;
+static std::unordered_map<std::string, uint64_t> changeCounters;
+
+static std::vector<std::string> pendingNotifications;
+static std::mutex listenersMutex;
+static std::vector<FileChangeListener> listeners;
+
+static std::string NormalizePath(const fs::path& path) {
+    return path.lexically_normal().generic_string();
+}
+
+static bool IsCovered(const std::string& path) {
+    if (path == watchedExtraFile) return true;
+    return path.size() > watchedRoot.size() && path.compare(0, watchedRoot.size(), watchedRoot) == 0 &&
+        path[watchedRoot.size()] == '/';
+}
+
+// Caller holds watcherMutex.
+static void RecordChange(const std::string& path) {
+    if (!path.empty() && !IsCovered(path)) return;
+    if (path.empty()) ++watcherEpoch;
+    else ++changeCounters[path];
+    pendingNotifications.push_back(path);
+}
+
+#ifdef __linux__
+
+static int inotifyFd = -1;
+static std::unordered_map<int, std::string> watchDirs; // watch descriptor -> normalized directory
+
+static constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+static std::string ExtraFileDirectory() {
+    std::string dir = NormalizePath(fs::path(watchedExtraFile).parent_path());
+    return dir.empty() ? "." : dir;
+}
+
+// Caller holds watcherMutex.
+static void AddDirectoryWatch(const std::string& dir, bool recursive) {
+    int wd = inotify_add_watch(inotifyFd, dir.c_str(), WATCH_MASK);
+    if (wd < 0) return;
+    watchDirs[wd] = dir;
+    if (!recursive) return;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        if (entry.is_directory(ec)) AddDirectoryWatch(NormalizePath(entry.path()), true);
+    }
+}
+
+// Caller holds watcherMutex.
+static void HandleInotifyEvent(const inotify_event& event) {
+    if (event.mask & IN_Q_OVERFLOW) {
+        RecordChange("");
+        return;
+    }
+    auto it = watchDirs.find(event.wd);
+    if (it == watchDirs.end()) return;
+    const std::string dir = it->second;
+
+    if (event.mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+        if (dir == watchedRoot || dir == ExtraFileDirectory()) watchIntact = false;
+        if (event.mask & IN_IGNORED) watchDirs.erase(it);
+        RecordChange("");
+        return;
+    }
+    if (event.len == 0) return;
+
+    std::string path = NormalizePath(fs::path(dir) / event.name);
+    if (event.mask & IN_ISDIR) {
+        if (!IsCovered(path)) return;
+        // Whole subtrees may appear or vanish at once; files inside them produce
+        // no events of their own.
+        if (event.mask & (IN_CREATE | IN_MOVED_TO)) AddDirectoryWatch(path, true);
+        RecordChange("");
+        return;
+    }
+    RecordChange(path);
+}
+
+// Caller holds watcherMutex. Reads whatever the kernel has queued without blocking.
+static void DrainInotifyEvents() {
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true) {
+        ssize_t n = read(inotifyFd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        for (char* p = buffer; p < buffer + n;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            HandleInotifyEvent(*event);
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+static bool StartInotify() {
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) return false;
+    AddDirectoryWatch(watchedRoot, true);
+    AddDirectoryWatch(ExtraFileDirectory(), false);
+    if (watchDirs.empty()) {
+        close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+    return true;
+}
+
+static void StopInotify() {
+    if (inotifyFd >= 0) close(inotifyFd);
+    inotifyFd = -1;
+    watchDirs.clear();
+}
+
+#endif
+
+// --- polling fallback ---
+
+struct PolledStamp {
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+
+    bool operator==(const PolledStamp&) const = default;
+};
+
+static std::map<std::string, PolledStamp> ScanStamps() {
+    std::map<std::string, PolledStamp> stamps;
+    std::error_code ec;
+    auto add = [&](const fs::path& path) {
+        PolledStamp stamp;
+        stamp.size = fs::file_size(path, ec);
+        if (ec) return;
+        stamp.mtime = fs::last_write_time(path, ec);
+        if (ec) return;
+        stamps[NormalizePath(path)] = stamp;
+    };
+    for (auto it = fs::recursive_directory_iterator(watchedRoot, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec)) add(it->path());
+    }
+    add(watchedExtraFile);
+    return stamps;
+}
+
+static void PollForChanges(std::map<std::string, PolledStamp>& known) {
+    ScopedTimer timer("FileWatcher::Poll");
+    std::map<std::string, PolledStamp> current = ScanStamps();
+
+    std::lock_guard<std::mutex> lock(watcherMutex);
+    for (const auto& [path, stamp] : current) {
+        auto it = known.find(path);
+        if (it == known.end() || !(it->second == stamp)) RecordChange(path);
+    }
+    for (const auto& [path, stamp] : known) {
+        if (!current.contains(path)) RecordChange(path);
+    }
+    known = std::move(current);
+}
+
+// --- watcher thread ---
+
+static void NotifyListeners() {
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(watcherMutex);
+        paths.swap(pendingNotifications);
+    }
+    if (paths.empty()) return;
+    // One save usually produces several events for the same file.
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+    std::lock_guard<std::mutex> lock(listenersMutex);
+    for (const auto& path : paths) {
+        for (const auto& listener : listeners) listener(path);
+    }
+}
+
+static void WatcherLoop(WatcherMode mode) {
+    std::map<std::string, PolledStamp> known;
+    if (mode == WatcherMode::Polling) known = ScanStamps();
+
+    auto nextPoll = std::chrono::steady_clock::now() + POLL_INTERVAL;
+    while (!watcherStopping) {
+#ifdef __linux__
+        if (mode == WatcherMode::Inotify) {
+            pollfd pfd{ inotifyFd, POLLIN, 0 };
+            if (poll(&pfd, 1, 200) <= 0) continue;
+            // Let a burst of events (an editor save, a branch switch) settle before
+            // notifying, so listeners run once per burst.
+            do {
+                std::lock_guard<std::mutex> lock(watcherMutex);
+                DrainInotifyEvents();
+            } while (!watcherStopping && poll(&pfd, 1, 50) > 0);
+            NotifyListeners();
+            continue;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() < nextPoll) continue;
+        PollForChanges(known);
+        NotifyListeners();
+        nextPoll = std::chrono::steady_clock::now() + POLL_INTERVAL;
+    }
+}
+
+bool StartFileWatcher(const std::string& directory, const std::string& extraFile) {
+    StopFileWatcher();
+
+    std::lock_guard<std::mutex> lock(watcherMutex);
+    watchedRoot = NormalizePath(directory);
+    watchedExtraFile = NormalizePath(extraFile);
+    ++watcherEpoch;
+    changeCounters.clear();
+    pendingNotifications.clear();
+
+    std::error_code ec;
+    if (!fs::is_directory(watchedRoot, ec)) return false;
+
+    watcherMode = WatcherMode::Polling;
+#ifdef __linux__
+    if (StartInotify()) watcherMode = WatcherMode::Inotify;
+#endif
+    watchIntact = true;
+    watcherStopping = false;
+    watcherThread = std::thread(WatcherLoop, watcherMode);
+    return true;
+}
+
+void StopFileWatcher() {
+    if (!watcherThread.joinable()) return;
+    watcherStopping = true;
+    watcherThread.join();
+
+    std::lock_guard<std::mutex> lock(watcherMutex);
+#ifdef __linux__
+    StopInotify();
+#endif
+    watcherMode = WatcherMode::Off;
+    watchIntact = false;
+}
+
+const char* FileWatcherMode() {
+    std::lock_guard<std::mutex> lock(watcherMutex);
+    switch (watcherMode) {
+    case WatcherMode::Inotify: return "inotify";
+    case WatcherMode::Polling: return "polling";
+    default: return "off";
+    }
+}
+
+bool GetWatchedFileVersion(const std::string& filename, uint64_t& version) {
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(watcherMutex);
+    if (watcherMode != WatcherMode::Inotify || !watchIntact) return false;
+
+    std::string path = NormalizePath(filename);
+    if (!IsCovered(path)) return false;
+    DrainInotifyEvents();
+    if (!watchIntact) return false;
+
+    auto it = changeCounters.find(path);
+    version = (watcherEpoch << 32) + (it == changeCounters.end() ? 0 : it->second);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AddFileChangeListener(FileChangeListener listener) {
+    std::lock_guard<std::mutex> lock(listenersMutex);
+    listeners.push_back(std::move(listener));
+}
+
+bool StartWorkspaceWatcher() {
+    static std::once_flag listenerRegistered;
+    std::call_once(listenerRegistered, [] {
+        std::string definitionsPath = NormalizePath(DEFINITIONS_FILE_PATH);
+        AddFileChangeListener([definitionsPath](const std::string& path) {
+            if (path.empty() || path == definitionsPath) PrewarmDefinitionIndex(DEFINITIONS_FILE_PATH);
+        });
+    });
+    return StartFileWatcher(GL_IMPL_DIRECTORY_PATH, CMAKELISTS_FILE_PATH);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <cstdint>
+
+// Background watcher over a directory tree and one extra file. On Linux it uses
+// inotify; elsewhere, or when inotify is unavailable, it polls file stamps.
+bool StartFileWatcher(const std::string& directory, const std::string& extraFile);
+void StopFileWatcher();
+// "inotify", "polling" or "off".
+const char* FileWatcherMode();
+
+// Starts the watcher over GL_IMPL_DIRECTORY_PATH and CMAKELISTS_FILE_PATH and
+// re-parses the definitions file in the background whenever it changes.
+bool StartWorkspaceWatcher();
+
+// Returns true if an event-driven watcher covers the file. 'version' then changes
+// whenever the file may have changed on disk. Pending events are drained first,
+// so every write that finished before the call is accounted for. The polling
+// fallback is never trusted here, since it only notices changes after a delay.
+bool GetWatchedFileVersion(const std::string& filename, uint64_t& version);
+
+// Called on the watcher thread with the normalized path of each changed file, or
+// with an empty path when an unknown set of files may have changed.
+using FileChangeListener = std::function<void(const std::string& path)>;
+void AddFileChangeListener(FileChangeListener listener);
@@ -0,0 +1,239 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "History.h"
+#include "FileUtils.h"
+
+// The file is rewritten on exit once erased duplicates and dropped entries make
+// up most of it.
+static constexpr size_t REWRITE_MIN_LINES = 1000;
+
+static std::string DefaultHistoryPath() {
+    if (const char* path = std::getenv("MGCM_HISTORY_FILE")) return path;
+#ifdef _WIN32
+    const char* home = std::getenv("USERPROFILE");
+#else
+    const char* home = std::getenv("HOME");
+#endif
+    if (!home || !*home) return "";
+    return std::string(home) + "/.mgcm_history";
+}
+
+CommandHistory::CommandHistory() {
+    if (const char* size = std::getenv("MGCM_HISTORY_SIZE")) {
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(size, &end, 10);
+        if (end != size && *end == '\0' && value > 0) capacity = static_cast<size_t>(value);
+    }
+    filePath = DefaultHistoryPath();
+    if (filePath.empty()) {
+        loadDone = true;
+        return;
+    }
+    loader = std::thread([this] { LoadFile(); });
+}
+
+CommandHistory::~CommandHistory() {
+    if (loader.joinable()) loader.join();
+    if (filePath.empty()) return;
+    Refresh();
+    if (fileLineCount < REWRITE_MIN_LINES || fileLineCount <= 2 * store.liveCount) return;
+
+    std::string content;
+    for (const auto& entry : store.entries) {
+        if (entry.empty()) continue;
+        content += entry;
+        content += '\n';
+    }
+    try {
+        WriteFileToDisk(filePath, content);
+    }
+    catch (const std::exception&) {
+        // Keeping the longer file is harmless.
+    }
+}
+
+static void SplitLines(const char* data, size_t size, std::vector<std::string>& lines) {
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const char* lineEnd = newline ? newline : end;
+        size_t length = lineEnd - data;
+        if (length > 0 && data[length - 1] == '\r') --length;
+        if (length > 0) lines.emplace_back(data, length);
+        data = newline ? newline + 1 : end;
+    }
+}
+
+void CommandHistory::LoadFile() {
+    std::vector<std::string> lines;
+#ifdef _WIN32
+    try {
+        if (IsFileExists(filePath)) {
+            std::string content = ReadFileFromDisk(filePath);
+            SplitLines(content.data(), content.size(), lines);
+        }
+    }
+    catch (const std::exception&) {
+    }
+#else
+    // Only the size seen here is mapped, so lines appended by this session while
+    // loading are not read back.
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size_t size = static_cast<size_t>(st.st_size);
+            void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                madvise(data, size, MADV_SEQUENTIAL);
+                SplitLines(static_cast<const char*>(data), size, lines);
+                munmap(data, size);
+            }
+        }
+        close(fd);
+    }
+#endif
+    loadedLineCount = lines.size();
+
+    // Deduplicate, cap and index here, off the prompt's thread; Refresh then
+    // only replays the lines entered in this session.
+    std::unordered_set<std::string_view> seen;
+    std::vector<size_t> keep;
+    for (size_t i = lines.size(); i-- > 0 && keep.size() < capacity;) {
+        if (seen.insert(lines[i]).second) keep.push_back(i);
+    }
+    seen.clear();
+    std::vector<std::string> kept;
+    kept.reserve(keep.size());
+    for (auto it = keep.rbegin(); it != keep.rend(); ++it) kept.push_back(std::move(lines[*it]));
+    loaded.Assign(std::move(kept));
+    loadDone.store(true, std::memory_order_release);
+}
+
+void CommandHistory::Refresh() {
+    if (merged || !loadDone.load(std::memory_order_acquire)) return;
+    if (loader.joinable()) loader.join();
+    merged = true;
+    fileLineCount += loadedLineCount;
+    if (loaded.entries.empty()) return;
+
+    // Lines entered in this session are newer than anything in the file.
+    Store session = std::move(store);
+    store = std::move(loaded);
+    loaded = Store();
+    for (const auto& line : session.entries) {
+        if (!line.empty()) store.Insert(line, capacity);
+    }
+}
+
+uint64_t CommandHistory::CharacterMask(std::string_view text) {
+    uint64_t mask = 0;
+    for (unsigned char c : text) mask |= uint64_t(1) << (c & 63);
+    return mask;
+}
+
+void CommandHistory::Store::Assign(std::vector<std::string> lines) {
+    entries = std::move(lines);
+    masks.resize(entries.size());
+    positionByLine.clear();
+    positionByLine.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        masks[i] = CharacterMask(entries[i]);
+        positionByLine.emplace(entries[i], i);
+    }
+    erasedCount = 0;
+    liveCount = entries.size();
+    oldestLive = 0;
+}
+
+void CommandHistory::Store::Erase(size_t position) {
+    positionByLine.erase(entries[position]);
+    entries[position].clear();
+    masks[position] = 0;
+    ++erasedCount;
+    --liveCount;
+}
+
+void CommandHistory::Store::Insert(const std::string& line, size_t capacity) {
+    auto it = positionByLine.find(line);
+    if (it != positionByLine.end()) Erase(it->second);
+    positionByLine[line] = entries.size();
+    entries.push_back(line);
+    masks.push_back(CharacterMask(line));
+    ++liveCount;
+
+    while (liveCount > capacity) {
+        while (entries[oldestLive].empty()) ++oldestLive;
+        Erase(oldestLive);
+    }
+    if (erasedCount > REWRITE_MIN_LINES && erasedCount > liveCount) {
+        std::vector<std::string> lines;
+        lines.reserve(liveCount);
+        for (auto& entry : entries) {
+            if (!entry.empty()) lines.push_back(std::move(entry));
+        }
+        Assign(std::move(lines));
+    }
+}
+
+void CommandHistory::Add(const std::string& line) {
+    if (line.empty()) return;
+    store.Insert(line, capacity);
+
+    if (!filePath.empty()) {
+        std::ofstream file(filePath, std::ios::binary | std::ios::app);
+        if (file) {
+            file << line << '\n';
+            ++fileLineCount;
+        }
+    }
+}
+
+bool CommandHistory::Older(size_t& position) {
+    const auto& entries = store.entries;
+    for (size_t i = std::min(position, entries.size()); i-- > 0;) {
+        if (!entries[i].empty()) {
+            position = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CommandHistory::Newer(size_t& position) {
+    const auto& entries = store.entries;
+    if (position >= entries.size()) return false;
+    size_t i = position + 1;
+    while (i < entries.size() && entries[i].empty()) ++i;
+    position = i;
+    return true;
+}
+
+bool CommandHistory::SearchBackward(std::string_view query, size_t start, size_t& position) {
+    const auto& entries = store.entries;
+    if (query.empty() || entries.empty()) return false;
+    uint64_t queryMask = CharacterMask(query);
+    // The mask rejects most entries without touching their text.
+    for (size_t i = std::min(start, entries.size() - 1) + 1; i-- > 0;) {
+        if ((store.masks[i] & queryMask) != queryMask) continue;
+        if (entries[i].find(query) != std::string::npos) {
+            position = i;
+            return true;
+        }
+    }
+    return false;
+}
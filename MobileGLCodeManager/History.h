@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// Command history shared by the prompt's arrow keys and Ctrl-R search.
+//
+// Lines are appended to a history file as they are entered. The file is
+// loaded on a background thread, so a large history never delays the first
+// prompt; entries from it appear once loading is done. A repeated command moves
+// to the newest position instead of being stored twice, and at most Capacity()
+// commands are kept.
+//
+// The file is $MGCM_HISTORY_FILE, or ~/.mgcm_history when that is not set. An
+// empty MGCM_HISTORY_FILE keeps history in memory only. MGCM_HISTORY_SIZE sets
+// the capacity (default 10000).
+class CommandHistory {
+public:
+    CommandHistory();
+    ~CommandHistory();
+
+    CommandHistory(const CommandHistory&) = delete;
+    CommandHistory& operator=(const CommandHistory&) = delete;
+
+    void Add(const std::string& line);
+
+    // Adopts the background load once it has finished. Positions handed out
+    // earlier become invalid, so call it only before starting to navigate.
+    void Refresh();
+
+    // Positions run from 0 (oldest) to End() (one past the newest). Erased
+    // duplicates leave holes, so step with Older/Newer rather than +-1.
+    size_t End() const { return store.entries.size(); }
+    // Step to the next older/newer entry; Newer steps from the newest to End().
+    // Both return false, leaving 'position' unchanged, when there is nowhere to go.
+    bool Older(size_t& position);
+    bool Newer(size_t& position);
+    const std::string& At(size_t position) const { return store.entries[position]; }
+
+    // Newest entry at or before 'start' that contains 'query', or false.
+    bool SearchBackward(std::string_view query, size_t start, size_t& position);
+
+    size_t Capacity() const { return capacity; }
+
+private:
+    // Entries oldest first. A line entered again leaves an empty string at its
+    // old position, so positions stay valid until holes are compacted away.
+    struct Store {
+        std::vector<std::string> entries;
+        std::vector<uint64_t> masks; // per entry: one bit per character class present
+        std::unordered_map<std::string, size_t> positionByLine;
+        size_t erasedCount = 0;
+        size_t liveCount = 0;
+        size_t oldestLive = 0;
+
+        // 'lines' must not contain duplicates.
+        void Assign(std::vector<std::string> lines);
+        // Moves or adds the line to the newest position, keeping at most 'capacity' entries.
+        void Insert(const std::string& line, size_t capacity);
+        void Erase(size_t position);
+    };
+
+    void LoadFile();
+
+    static uint64_t CharacterMask(std::string_view text);
+
+    Store store;
+    size_t capacity = 10000;
+
+    std::string filePath; // empty: not persisted
+    size_t fileLineCount = 0; // lines in the file, duplicates included
+
+    // Filled by the loader thread; adopted by Refresh once loadDone is set.
+    std::thread loader;
+    std::atomic<bool> loadDone{ false };
+    bool merged = false;
+    Store loaded;
+    size_t loadedLineCount = 0;
+};
@@ -0,0 +1,193 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+#include "Instrumentation.h"
+#include "FileUtils.h"
+#include "Progress.h"
+
+std::atomic<bool> instrumentationActive{ false };
+
+struct PhaseStats {
+    uint64_t calls = 0;
+    int64_t totalNs = 0;
+    int64_t maxNs = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t filesRead = 0;
+    uint64_t filesWritten = 0;
+};
+
+struct TraceEvent {
+    std::string name;
+    int64_t startNs;
+    int64_t durationNs;
+    size_t threadId;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+};
+
+static std::mutex instrumentationMutex;
+static bool statsEnabled = false;
+static bool traceEnabled = false;
+static std::string traceFilename;
+static std::map<std::string, PhaseStats> phaseStats;
+static std::vector<TraceEvent> traceEvents;
+static thread_local ScopedTimer* currentTimer = nullptr;
+static std::atomic<size_t> nextThreadId{ 0 };
+static thread_local size_t traceThreadId = ++nextThreadId;
+
+static int64_t NowNs() {
+    using namespace std::chrono;
+    static const steady_clock::time_point origin = steady_clock::now();
+    return duration_cast<nanoseconds>(steady_clock::now() - origin).count();
+}
+
+static void UpdateActiveFlag() {
+    instrumentationActive.store(statsEnabled || traceEnabled, std::memory_order_relaxed);
+}
+
+void SetStatsEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(instrumentationMutex);
+    statsEnabled = enabled;
+    UpdateActiveFlag();
+}
+
+bool IsStatsEnabled() {
+    std::lock_guard<std::mutex> lock(instrumentationMutex);
+    return statsEnabled;
+}
+
+void ResetStats() {
+    std::lock_guard<std::mutex> lock(instrumentationMutex);
+    phaseStats.clear();
+}
+
+void PrintStats(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(instrumentationMutex);
+    if (phaseStats.empty()) {
+        out << "No statistics recorded" << (statsEnabled ? "" : " (enable with 'stats on')") << std::endl;
+        return;
+    }
+
+    out << std::left << std::setw(36) << "Phase" << std::right
+        << std::setw(8) << "Calls" << std::setw(12) << "Total ms" << std::setw(10) << "Max ms"
+        << std::setw(12) << "Read KiB" << std::setw(12) << "Write KiB" << std::setw(12) << "Files R/W" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& [name, stats] : phaseStats) {
+        std::string files = std::to_string(stats.filesRead) + "/" + std::to_string(stats.filesWritten);
+        out << std::left << std::setw(36) << name << std::right
+            << std::setw(8) << stats.calls
+            << std::setw(12) << stats.totalNs / 1e6
+            << std::setw(10) << stats.maxNs / 1e6
+            << std::setw(12) << stats.bytesRead / 1024.0
+            << std::setw(12) << stats.bytesWritten / 1024.0
+            << std::setw(12) << files << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+void StartTrace(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(instrumentationMutex);
+    traceFilename = filename;
+    traceEvents.clear();
+    traceEnabled = true;
+    UpdateActiveFlag();
+}
+
+static void AppendJsonString(std::string& out, std::string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+bool FinishTrace() {
+    std::vector<TraceEvent> events;
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(instrumentationMutex);
+        if (!traceEnabled) return false;
+        traceEnabled = false;
+        UpdateActiveFlag();
+        events.swap(traceEvents);
+        filename = traceFilename;
+    }
+
+    // Chrome trace-event format, one complete ("X") event per timer.
+    std::string json = "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        json += "{\"name\":";
+        AppendJsonString(json, event.name);
+        json += ",\"cat\":\"mgcm\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(event.threadId);
+        json += ",\"ts\":" + std::to_string(event.startNs / 1000.0);
+        json += ",\"dur\":" + std::to_string(event.durationNs / 1000.0);
+        json += ",\"args\":{\"bytesRead\":" + std::to_string(event.bytesRead) +
+            ",\"bytesWritten\":" + std::to_string(event.bytesWritten) + "}}";
+        json += i + 1 < events.size() ? ",\n" : "\n";
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}\n";
+
+    try {
+        WriteFileToDisk(filename, json);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+    std::cerr << "Wrote " << events.size() << " trace events to " << filename << std::endl;
+    return true;
+}
+
+void RecordFileRead(uint64_t bytes) {
+    AddProgressFile();
+    for (ScopedTimer* timer = currentTimer; timer; timer = timer->parent) {
+        timer->bytesRead += bytes;
+        ++timer->filesRead;
+    }
+}
+
+void RecordFileWrite(uint64_t bytes) {
+    AddProgressFile();
+    for (ScopedTimer* timer = currentTimer; timer; timer = timer->parent) {
+        timer->bytesWritten += bytes;
+        ++timer->filesWritten;
+    }
+}
+
+void ScopedTimer::Begin(std::string_view phase) {
+    active = true;
+    name = phase;
+    parent = currentTimer;
+    currentTimer = this;
+    startNs = NowNs();
+}
+
+void ScopedTimer::End() {
+    int64_t durationNs = NowNs() - startNs;
+    currentTimer = parent;
+
+    std::lock_guard<std::mutex> lock(instrumentationMutex);
+    if (statsEnabled) {
+        PhaseStats& stats = phaseStats[name];
+        ++stats.calls;
+        stats.totalNs += durationNs;
+        stats.maxNs = std::max(stats.maxNs, durationNs);
+        stats.bytesRead += bytesRead;
+        stats.bytesWritten += bytesWritten;
+        stats.filesRead += filesRead;
+        stats.filesWritten += filesWritten;
+    }
+    if (traceEnabled) {
+        traceEvents.push_back({ std::move(name), startNs, durationNs, traceThreadId, bytesRead, bytesWritten });
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+// Lightweight timing and I/O accounting. While neither stats nor tracing is
+// enabled, a ScopedTimer costs one relaxed atomic load and records nothing.
+extern std::atomic<bool> instrumentationActive;
+
+inline bool IsInstrumentationActive() {
+    return instrumentationActive.load(std::memory_order_relaxed);
+}
+
+void SetStatsEnabled(bool enabled);
+bool IsStatsEnabled();
+void ResetStats();
+void PrintStats(std::ostream& out);
+
+// Starts collecting Chrome trace events (chrome://tracing, Perfetto); they are
+// written to 'filename' by FinishTrace().
+void StartTrace(const std::string& filename);
+bool FinishTrace();
+
+// Charged to every timer that is active on the calling thread.
+void RecordFileRead(uint64_t bytes);
+void RecordFileWrite(uint64_t bytes);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(std::string_view phase) {
+        if (IsInstrumentationActive()) Begin(phase);
+    }
+    ~ScopedTimer() {
+        if (active) End();
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    friend void RecordFileRead(uint64_t bytes);
+    friend void RecordFileWrite(uint64_t bytes);
+
+    void Begin(std::string_view phase);
+    void End();
+
+    bool active = false;
+    std::string name;
+    int64_t startNs = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint32_t filesRead = 0;
+    uint32_t filesWritten = 0;
+    ScopedTimer* parent = nullptr;
+};
@@ -0,0 +1,600 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <conio.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+#include "LineEditor.h"
+#include "Completion.h"
+
+bool LineEditor::readLine(const std::string& prompt, std::string& outLine) {
+#ifdef _WIN32
+    return readLineWindows(prompt, outLine);
+#else
+    return readLinePosix(prompt, outLine);
+#endif
+}
+
+void PromptOutput::PrintCompleteLines() {
+    size_t end = pending.rfind('\n');
+    if (end == std::string::npos) return;
+    editor.printAbove(pending.substr(0, end + 1));
+    pending.erase(0, end + 1);
+}
+
+PromptOutput::int_type PromptOutput::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+    std::lock_guard<std::mutex> lock(mutex);
+    pending += traits_type::to_char_type(c);
+    if (c == '\n') PrintCompleteLines();
+    return c;
+}
+
+std::streamsize PromptOutput::xsputn(const char* s, std::streamsize n) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.append(s, static_cast<size_t>(n));
+    if (std::char_traits<char>::find(s, static_cast<size_t>(n), '\n')) PrintCompleteLines();
+    return n;
+}
+
+int PromptOutput::sync() {
+    // A partial line stays pending: std::cerr flushes after every insertion.
+    std::lock_guard<std::mutex> lock(mutex);
+    PrintCompleteLines();
+    return 0;
+}
+
+int LineEditor::terminalWidth() {
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+        return info.srWindow.Right - info.srWindow.Left + 1;
+    }
+#else
+    winsize ws{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) return ws.ws_col;
+#endif
+    return 80;
+}
+
+bool LineEditor::completeBuffer(std::string& buffer, size_t& cursor, std::string& listing, const char* newline) {
+    CompletionResult result = CompleteCommandLine(buffer, cursor, COMPLETION_LIST_LIMIT);
+    if (result.total == 0) return false;
+
+    size_t wordLength = cursor - result.wordStart;
+    std::string insertion;
+    if (result.commonPrefix.size() > wordLength) insertion = result.commonPrefix.substr(wordLength);
+    if (result.total == 1 && result.spaceAfterUnique) insertion += ' ';
+    if (!insertion.empty()) {
+        buffer.insert(cursor, insertion);
+        cursor += insertion.size();
+        return true;
+    }
+
+    size_t columnWidth = 0;
+    for (const auto& candidate : result.candidates) columnWidth = std::max(columnWidth, candidate.size() + 2);
+    size_t columns = std::max<size_t>(1, static_cast<size_t>(terminalWidth()) / columnWidth);
+    listing = newline;
+    for (size_t i = 0; i < result.candidates.size(); ++i) {
+        listing += result.candidates[i];
+        bool endOfRow = (i + 1) % columns == 0 || i + 1 == result.candidates.size();
+        if (endOfRow) listing += newline;
+        else listing.append(columnWidth - result.candidates[i].size(), ' ');
+    }
+    if (result.total > result.candidates.size()) {
+        listing += "... and " + std::to_string(result.total - result.candidates.size()) + " more" + newline;
+    }
+    return true;
+}
+
+void LineEditor::addHistory(const std::string& line) {
+    history.Add(line);
+    browsingHistory = false;
+}
+
+void LineEditor::historyUp(std::string& buffer, size_t& cursor) {
+    if (!browsingHistory) {
+        // Entries loaded in the background join here, never in the middle of browsing.
+        history.Refresh();
+        historyPosition = history.End();
+    }
+    if (!history.Older(historyPosition)) return;
+    browsingHistory = true;
+    buffer = history.At(historyPosition);
+    cursor = buffer.size();
+}
+
+void LineEditor::historyDown(std::string& buffer, size_t& cursor) {
+    if (!browsingHistory || !history.Newer(historyPosition)) return;
+    if (historyPosition == history.End()) {
+        browsingHistory = false;
+        buffer.clear();
+    } else {
+        buffer = history.At(historyPosition);
+    }
+    cursor = buffer.size();
+}
+
+void LineEditor::startSearch(const std::string& buffer) {
+    history.Refresh();
+    browsingHistory = false;
+    search = ReverseSearch();
+    search.active = true;
+    search.position = history.End();
+    search.savedBuffer = buffer;
+}
+
+std::string LineEditor::searchPrompt() const {
+    return std::string(search.failing ? "(failing reverse-i-search)`" : "(reverse-i-search)`") + search.query + "': ";
+}
+
+bool LineEditor::searchKey(int c, std::string& buffer, size_t& cursor) {
+    // Searches from 'start' (inclusive) towards older entries and shows the match.
+    auto find = [&](size_t start) {
+        size_t found = 0;
+        search.failing = !history.SearchBackward(search.query, start, found);
+        if (search.failing) return;
+        search.position = found;
+        buffer = history.At(found);
+        cursor = buffer.find(search.query);
+    };
+
+    if (c == 18) { // Ctrl-R again: next older match
+        if (!search.query.empty() && !search.failing) {
+            if (search.position == 0) search.failing = true;
+            else find(search.position - 1);
+        }
+    } else if (c == 7 || c == 3) { // Ctrl-G, Ctrl-C: back to the line as it was
+        buffer = search.savedBuffer;
+        cursor = buffer.size();
+        search.active = false;
+    } else if (c == 127 || c == 8) {
+        if (!search.query.empty()) {
+            search.query.pop_back();
+            search.failing = false;
+            if (search.query.empty()) search.position = history.End();
+            else find(history.End());
+        }
+    } else if (c >= 32 && c <= 126) {
+        search.query += (char)c;
+        // The shown entry may still match the longer query.
+        if (!search.failing) find(search.position);
+    } else {
+        search.active = false;
+        return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+int LineEditor::getch_nonblocking() {
+    // blocking _getch
+    return _getch();
+}
+
+bool LineEditor::readLineWindows(const std::string& prompt, std::string& outLine) {
+    std::string buffer;
+    size_t cursor = 0;
+    int prevDisplayLen = 0;
+
+    std::cout << prompt;
+    std::cout.flush();
+
+    while (true) {
+        int c = getch_nonblocking();
+        if (search.active) {
+            if (searchKey(c, buffer, cursor)) {
+                redraw(search.active ? searchPrompt() : prompt, buffer, cursor, prevDisplayLen);
+                continue;
+            }
+            redraw(prompt, buffer, cursor, prevDisplayLen);
+        }
+
+        if (c == 0 || c == 224) {
+            // special key, read next
+            int c2 = getch_nonblocking();
+            if (c2 == 72) { // up
+                historyUp(buffer, cursor);
+                redraw(prompt, buffer, cursor, prevDisplayLen);
+            } else if (c2 == 80) { // down
+                historyDown(buffer, cursor);
+                redraw(prompt, buffer, cursor, prevDisplayLen);
+            } else if (c2 == 75) { // left
+                if (cursor > 0) {
+                    --cursor;
+                    moveCursorLeft(1);
+                }
+            } else if (c2 == 77) { // right
+                if (cursor < buffer.size()) {
+                    ++cursor;
+                    redraw(prompt, buffer, cursor, prevDisplayLen);
+                }
+            } else {
+                // ignore others
+            }
+        } else if (c == 13) {
+            // Enter
+            std::cout << std::endl;
+            addHistory(buffer);
+            outLine = buffer;
+            return true;
+        } else if (c == 3) {
+            // Ctrl-C
+            if (onInterrupt && onInterrupt()) continue;
+            std::cout << "^C" << std::endl;
+            buffer.clear();
+            cursor = 0;
+            redraw(prompt, buffer, cursor, prevDisplayLen);
+            // do not exit program; just clear
+        } else if (c == 8) {
+            // Backspace
+            if (cursor > 0) {
+                buffer.erase(cursor - 1, 1);
+                --cursor;
+                redraw(prompt, buffer, cursor, prevDisplayLen);
+            }
+        } else if (c == 9) {
+            // Tab
+            std::string listing;
+            if (!completeBuffer(buffer, cursor, listing, "\n")) {
+                std::cout << '\a';
+            }
+            if (!listing.empty()) {
+                std::cout << listing;
+                prevDisplayLen = 0;
+            }
+            redraw(prompt, buffer, cursor, prevDisplayLen);
+        } else if (c == 18) {
+            // Ctrl-R
+            startSearch(buffer);
+            redraw(searchPrompt(), buffer, cursor, prevDisplayLen);
+        } else if (c == 0x1a) {
+            // Ctrl-Z maybe EOF in some consoles; treat as EOF
+            std::cout << std::endl;
+            return false;
+        } else if (c >= 32 && c <= 126) {
+            // printable
+            buffer.insert(buffer.begin() + cursor, (char)c);
+            ++cursor;
+            redraw(prompt, buffer, cursor, prevDisplayLen);
+        } else {
+            // ignore
+        }
+    } // while
+}
+
+void LineEditor::printAbove(const std::string& text) {
+    // Commands run in the foreground here, so there is no prompt to redraw.
+    fwrite(text.data(), 1, text.size(), stdout);
+    fflush(stdout);
+}
+
+void LineEditor::moveCursorLeft(int n) {
+    while (n--) std::cout << '\b';
+    std::cout.flush();
+}
+
+void LineEditor::redraw(const std::string& prompt, const std::string& buffer, size_t cursor, int& prevDisplayLen) {
+    // carriage return, print prompt + buffer, pad with spaces to clear leftover, then reposition cursor
+    std::cout << '\r' << prompt << buffer;
+    int curDisplayLen = (int)(prompt.size() + buffer.size());
+    if (prevDisplayLen > curDisplayLen) {
+        // clear leftover
+        for (int i = 0; i < prevDisplayLen - curDisplayLen; ++i) std::cout << ' ';
+        // move back again
+        std::cout << '\r' << prompt << buffer;
+    }
+    prevDisplayLen = curDisplayLen;
+    // move back from end to cursor position
+    int moveBack = (int)(buffer.size() - cursor);
+    for (int i = 0; i < moveBack; ++i) std::cout << '\b';
+    std::cout.flush();
+}
+
+#else // POSIX
+
+namespace {
+
+struct TermState {
+    termios orig;
+    bool valid = false;
+};
+
+bool enableRawMode(TermState& st) {
+    if (!isatty(STDIN_FILENO)) return false;
+    if (tcgetattr(STDIN_FILENO, &st.orig) == -1) return false;
+    termios raw = st.orig;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_iflag &= ~(IXON | ICRNL | BRKINT | INPCK | ISTRIP);
+    raw.c_oflag &= ~(OPOST);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    // TCSADRAIN rather than TCSAFLUSH, so keys typed (or pasted) while a command
+    // was running are not thrown away.
+    if (tcsetattr(STDIN_FILENO, TCSADRAIN, &raw) == -1) return false;
+    st.valid = true;
+    return true;
+}
+
+void disableRawMode(TermState& st) {
+    if (st.valid) {
+        tcsetattr(STDIN_FILENO, TCSADRAIN, &st.orig);
+        st.valid = false;
+    }
+}
+
+const char* BRACKETED_PASTE_ON = "\x1b[?2004h";
+const char* BRACKETED_PASTE_OFF = "\x1b[?2004l";
+
+} // namespace
+
+bool LineEditor::fillInput() {
+    while (true) {
+        ssize_t n = read(STDIN_FILENO, inputBuffer, sizeof(inputBuffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        inputPos = 0;
+        inputLength = static_cast<size_t>(n);
+        return true;
+    }
+}
+
+int LineEditor::nextByte() {
+    if (!hasBufferedInput()) {
+        // Other threads may print above the prompt while this one waits for a key.
+        if (displayLock) displayLock->unlock();
+        bool filled = fillInput();
+        if (displayLock) displayLock->lock();
+        if (!filled) return -1;
+    }
+    return static_cast<unsigned char>(inputBuffer[inputPos++]);
+}
+
+void LineEditor::printAbove(const std::string& text) {
+    std::lock_guard<std::mutex> lock(displayMutex);
+    bool editing = liveBuffer != nullptr;
+    if (editing && promptShown) output += "\r\x1b[K";
+    // The terminal is in raw mode while editing, so newlines need their '\r'.
+    for (char c : text) {
+        if (c == '\n' && editing) output += '\r';
+        output += c;
+    }
+    if (editing) {
+        promptShown = false;
+        render(search.active ? searchPrompt() : *livePrompt, *liveBuffer, *liveCursor);
+    }
+    flushOutput();
+}
+
+void LineEditor::moveCursor(size_t from, size_t to) {
+    if (to < from) {
+        size_t n = from - to;
+        output += n == 1 ? std::string("\b") : "\x1b[" + std::to_string(n) + "D";
+    } else if (to > from) {
+        output += "\x1b[" + std::to_string(to - from) + "C";
+    }
+}
+
+void LineEditor::render(const std::string& prompt, const std::string& buffer, size_t cursor) {
+    if (!promptShown || prompt != shownPrompt) {
+        output += '\r';
+        output += prompt;
+        output += "\x1b[K";
+        shownPrompt = prompt;
+        shownBuffer.clear();
+        shownCursor = 0;
+        promptShown = true;
+    }
+
+    size_t common = 0;
+    while (common < shownBuffer.size() && common < buffer.size() && shownBuffer[common] == buffer[common]) ++common;
+
+    if (common < shownBuffer.size() || common < buffer.size()) {
+        // Rewrite only the differing tail and clear what is left of the old text.
+        moveCursor(shownCursor, common);
+        output.append(buffer, common, std::string::npos);
+        if (shownBuffer.size() > buffer.size()) output += "\x1b[K";
+        shownCursor = buffer.size();
+        shownBuffer = buffer;
+    }
+    moveCursor(shownCursor, cursor);
+    shownCursor = cursor;
+}
+
+void LineEditor::flushOutput() {
+    size_t written = 0;
+    while (written < output.size()) {
+        ssize_t n = write(STDOUT_FILENO, output.data() + written, output.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += static_cast<size_t>(n);
+    }
+    output.clear();
+}
+
+bool LineEditor::readLinePosix(const std::string& prompt, std::string& outLine) {
+    std::cout.flush();
+
+    // Lines from an earlier multi-line paste run one by one, echoed like typed input.
+    if (!pastedLines.empty()) {
+        outLine = std::move(pastedLines.front());
+        pastedLines.pop_front();
+        addHistory(outLine);
+        std::cout << prompt << outLine << std::endl;
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(displayMutex);
+    TermState st;
+    enableRawMode(st);
+    output += BRACKETED_PASTE_ON;
+
+    std::string buffer = std::move(pendingInput);
+    pendingInput.clear();
+    size_t cursor = buffer.size();
+    promptShown = false;
+    search.active = false;
+    displayLock = &lock;
+    livePrompt = &prompt;
+    liveBuffer = &buffer;
+    liveCursor = &cursor;
+
+    bool inPaste = false;
+    bool lastWasCarriageReturn = false;
+    std::vector<std::string> pasted;
+
+    auto finish = [&](bool result) {
+        output += BRACKETED_PASTE_OFF;
+        flushOutput();
+        disableRawMode(st);
+        displayLock = nullptr;
+        livePrompt = nullptr;
+        liveBuffer = nullptr;
+        liveCursor = nullptr;
+        return result;
+    };
+
+    // Escape sequence: ESC [ <parameters> <final byte>. Returns the final byte,
+    // 0 for an escape that is not a CSI sequence, or -1 at the end of input.
+    auto readEscape = [&](std::string& parameters) {
+        int c1 = nextByte();
+        if (c1 != '[') return c1 == -1 ? -1 : 0;
+        int final = nextByte();
+        while (final != -1 && ((final >= '0' && final <= '9') || final == ';')) {
+            parameters += (char)final;
+            final = nextByte();
+        }
+        return final;
+    };
+
+    // Bracketed paste end. Returns true if a complete line was pasted: the first
+    // one becomes this call's line, the rest run on the next calls.
+    auto endPaste = [&] {
+        inPaste = false;
+        if (pasted.empty()) return false;
+        pendingInput = std::move(buffer);
+        buffer = std::move(pasted.front());
+        pastedLines.insert(pastedLines.end(), std::make_move_iterator(pasted.begin() + 1), std::make_move_iterator(pasted.end()));
+        pasted.clear();
+        cursor = buffer.size();
+        render(prompt, buffer, cursor);
+        output += "\r\n";
+        addHistory(buffer);
+        outLine = buffer;
+        return true;
+    };
+
+    while (true) {
+        // Everything already received is applied before anything is drawn, so a
+        // burst of input costs one terminal update.
+        if (!hasBufferedInput()) {
+            render(search.active ? searchPrompt() : prompt, buffer, cursor);
+            flushOutput();
+        }
+        int c = nextByte();
+        if (c == -1) {
+            output += "\r\n";
+            return finish(false);
+        }
+
+        if (inPaste) {
+            if (c == 27) {
+                // Only the end marker is recognised while pasting; any other
+                // sequence is part of the pasted text and is dropped.
+                std::string parameters;
+                int final = readEscape(parameters);
+                if (final == -1) return finish(false);
+                if (final == '~' && parameters == "201" && endPaste()) return finish(true);
+                continue;
+            }
+            if (c == '\r' || c == '\n') {
+                if (!(c == '\n' && lastWasCarriageReturn)) {
+                    pasted.push_back(std::move(buffer));
+                    buffer.clear();
+                    cursor = 0;
+                }
+            } else if (c == '\t') {
+                buffer.insert(buffer.begin() + cursor, ' ');
+                ++cursor;
+            } else if (c >= 32 && c <= 126) {
+                buffer.insert(buffer.begin() + cursor, (char)c);
+                ++cursor;
+            }
+            lastWasCarriageReturn = c == '\r';
+            continue;
+        }
+
+        if (search.active && searchKey(c, buffer, cursor)) continue;
+
+        if (c == '\r' || c == '\n') {
+            render(prompt, buffer, cursor);
+            output += "\r\n";
+            addHistory(buffer);
+            outLine = buffer;
+            return finish(true);
+        } else if (c == 127 || c == 8) { // backspace (127 on many terminals)
+            if (cursor > 0) {
+                buffer.erase(cursor - 1, 1);
+                --cursor;
+            }
+        } else if (c == 3) { // Ctrl-C
+            if (onInterrupt && onInterrupt()) continue;
+            render(prompt, buffer, cursor);
+            output += "^C\r\n";
+            promptShown = false;
+            buffer.clear();
+            cursor = 0;
+        } else if (c == 18) { // Ctrl-R
+            startSearch(buffer);
+        } else if (c == 4) { // Ctrl-D -> treat as EOF
+            output += "\r\n";
+            return finish(false);
+        } else if (c == 9) { // Tab
+            std::string listing;
+            if (!completeBuffer(buffer, cursor, listing, "\r\n")) {
+                output += '\a';
+            } else if (!listing.empty()) {
+                render(prompt, buffer, cursor);
+                output += listing;
+                promptShown = false;
+            }
+        } else if (c == 27) {
+            std::string parameters;
+            int final = readEscape(parameters);
+            if (final == -1) return finish(false);
+
+            if (final == '~' && parameters == "200") { // bracketed paste start
+                inPaste = true;
+                lastWasCarriageReturn = false;
+            } else if (final == 'A') { // up
+                historyUp(buffer, cursor);
+            } else if (final == 'B') { // down
+                historyDown(buffer, cursor);
+            } else if (final == 'C') { // right
+                if (cursor < buffer.size()) ++cursor;
+            } else if (final == 'D') { // left
+                if (cursor > 0) --cursor;
+            } else {
+                // other CSI sequences ignored
+            }
+        } else if (c >= 32 && c <= 126) {
+            buffer.insert(buffer.begin() + cursor, (char)c);
+            ++cursor;
+        } else {
+            // ignore other controls
+        }
+    } // while
+}
+
+#endif
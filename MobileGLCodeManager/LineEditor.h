@@ -0,0 +1,125 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <streambuf>
+
+#include "History.h"
+
+// Interactive line input for the prompt: cursor movement, persistent history
+// with Ctrl-R reverse search, and Tab completion. On POSIX terminals it reads input in chunks and renders each batch
+// of keystrokes as one minimal terminal update; pastes (bracketed or not) are
+// processed line by line without redrawing for every character.
+class LineEditor {
+public:
+    LineEditor() = default;
+
+    // Returns false on EOF/terminate
+    bool readLine(const std::string& prompt, std::string& outLine);
+
+    // Writes complete lines above the prompt and redraws the prompt and the line
+    // being edited below them. Safe to call from any thread while readLine waits.
+    void printAbove(const std::string& text);
+
+    // Called on Ctrl-C. Returning true means the key was used, e.g. to cancel a
+    // running command, and the line being edited is kept. Must not write to
+    // std::cout or std::cerr.
+    std::function<bool()> onInterrupt;
+
+private:
+    CommandHistory history;
+    bool browsingHistory = false; // Up/Down moved away from the edited line
+    size_t historyPosition = 0;
+
+    // Ctrl-R: the buffer shows the newest entry containing the query.
+    struct ReverseSearch {
+        bool active = false;
+        bool failing = false; // no entry contains the query; the last match stays shown
+        std::string query;
+        size_t position = 0;
+        std::string savedBuffer; // restored when the search is cancelled
+    };
+    ReverseSearch search;
+
+    static constexpr size_t COMPLETION_LIST_LIMIT = 200;
+
+    void addHistory(const std::string& line);
+    void historyUp(std::string& buffer, size_t& cursor);
+    void historyDown(std::string& buffer, size_t& cursor);
+    void startSearch(const std::string& buffer);
+    // Applies a key typed during a search. Returns false when the key ends the
+    // search and should then be handled as usual (Enter, arrows, Tab, ...).
+    bool searchKey(int c, std::string& buffer, size_t& cursor);
+    std::string searchPrompt() const;
+    int terminalWidth();
+    // Applies Tab completion to the buffer. Returns false if nothing matches. If
+    // nothing could be inserted, 'listing' receives the candidates in columns,
+    // each row ended by 'newline'.
+    bool completeBuffer(std::string& buffer, size_t& cursor, std::string& listing, const char* newline);
+
+#ifdef _WIN32
+    int getch_nonblocking();
+    bool readLineWindows(const std::string& prompt, std::string& outLine);
+    void moveCursorLeft(int n);
+    void redraw(const std::string& prompt, const std::string& buffer, size_t cursor, int& prevDisplayLen);
+#else
+    bool readLinePosix(const std::string& prompt, std::string& outLine);
+
+    // Input arrives in chunks; bytes left over from one line (type-ahead, pastes
+    // without bracketing) are kept for the next readLine.
+    bool fillInput();
+    int nextByte();
+    bool hasBufferedInput() const { return inputPos < inputLength; }
+
+    // Brings the terminal from what it shows to prompt + buffer with the cursor
+    // at 'cursor', appending only the difference to 'output'.
+    void render(const std::string& prompt, const std::string& buffer, size_t cursor);
+    void moveCursor(size_t from, size_t to);
+    void flushOutput();
+
+    char inputBuffer[4096];
+    size_t inputPos = 0;
+    size_t inputLength = 0;
+
+    std::string output;     // pending terminal output, written once per event
+    bool promptShown = false;
+    std::string shownPrompt;
+    std::string shownBuffer; // buffer as currently displayed after the prompt
+    size_t shownCursor = 0;
+
+    // Held while editing; released only while waiting for input, which is when
+    // printAbove can draw. live* point at the line being edited.
+    std::mutex displayMutex;
+    std::unique_lock<std::mutex>* displayLock = nullptr;
+    const std::string* livePrompt = nullptr;
+    const std::string* liveBuffer = nullptr;
+    const size_t* liveCursor = nullptr;
+
+    // Lines completed by a multi-line paste, returned by the next readLine calls;
+    // the unterminated tail of the paste becomes the next line's initial buffer.
+    std::deque<std::string> pastedLines;
+    std::string pendingInput;
+#endif
+};
+
+// Hands complete lines written to it to LineEditor::printAbove, so that output
+// of commands running in the background shows up above the prompt. Meant to be
+// shared by std::cout and std::cerr; a line is passed on once it is complete.
+class PromptOutput : public std::streambuf {
+public:
+    explicit PromptOutput(LineEditor& editor) : editor(editor) {}
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    void PrintCompleteLines();
+
+    LineEditor& editor;
+    std::mutex mutex;
+    std::string pending;
+};
@@ -0,0 +1,77 @@
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#include "Progress.h"
+
+static std::atomic<bool> cancellationRequested{ false };
+static std::atomic<uint64_t> itemsDone{ 0 };
+static std::atomic<uint64_t> itemsTotal{ 0 };
+static std::atomic<uint64_t> filesProcessed{ 0 };
+static std::atomic<int64_t> startNs{ 0 };
+
+static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void BeginCommandProgress() {
+    itemsDone = 0;
+    itemsTotal = 0;
+    filesProcessed = 0;
+    startNs = NowNs();
+    cancellationRequested = false;
+}
+
+void RequestCancellation() {
+    cancellationRequested.store(true, std::memory_order_relaxed);
+}
+
+bool IsCancellationRequested() {
+    return cancellationRequested.load(std::memory_order_relaxed);
+}
+
+void ThrowIfCancelled() {
+    if (IsCancellationRequested()) throw CommandCancelled();
+}
+
+void AddProgressTotal(uint64_t items) {
+    itemsTotal.fetch_add(items, std::memory_order_relaxed);
+}
+
+void AddProgressDone(uint64_t items) {
+    itemsDone.fetch_add(items, std::memory_order_relaxed);
+}
+
+void AddProgressFile() {
+    filesProcessed.fetch_add(1, std::memory_order_relaxed);
+}
+
+ProgressSnapshot GetCommandProgress() {
+    ProgressSnapshot progress;
+    progress.itemsDone = itemsDone.load(std::memory_order_relaxed);
+    progress.itemsTotal = itemsTotal.load(std::memory_order_relaxed);
+    progress.files = filesProcessed.load(std::memory_order_relaxed);
+    progress.seconds = (NowNs() - startNs.load(std::memory_order_relaxed)) / 1e9;
+    return progress;
+}
+
+std::string FormatProgress(const ProgressSnapshot& progress) {
+    std::string text;
+    auto append = [&](const std::string& part) {
+        if (!text.empty()) text += ", ";
+        text += part;
+    };
+    if (progress.itemsTotal > 0) {
+        append(std::to_string(progress.itemsDone) + "/" + std::to_string(progress.itemsTotal) + " items");
+    }
+    if (progress.files > 0) append(std::to_string(progress.files) + " files");
+    char buffer[64];
+    if (progress.itemsDone > 0 && progress.seconds > 0) {
+        snprintf(buffer, sizeof(buffer), "%.0f items/s", progress.itemsDone / progress.seconds);
+        append(buffer);
+    }
+    snprintf(buffer, sizeof(buffer), "%.1f s", progress.seconds);
+    append(buffer);
+    return text;
+}
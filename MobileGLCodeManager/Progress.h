@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+// Progress and cooperative cancellation of the running command. Long operations
+// report work items as they finish them and call ThrowIfCancelled() at points
+// where stopping leaves every file as it was or fully written; they never stop
+// in the middle of writing a set of files that belong together.
+class CommandCancelled : public std::runtime_error {
+public:
+    CommandCancelled() : std::runtime_error("cancelled") {}
+};
+
+// Resets the counters and any pending cancellation for the next command.
+void BeginCommandProgress();
+
+// Safe to call from a signal handler.
+void RequestCancellation();
+bool IsCancellationRequested();
+void ThrowIfCancelled();
+
+// Work items: components scanned, functions generated, files checked, ...
+void AddProgressTotal(uint64_t items);
+void AddProgressDone(uint64_t items = 1);
+// Called for every file read from or written to disk.
+void AddProgressFile();
+
+struct ProgressSnapshot {
+    uint64_t itemsDone = 0;
+    uint64_t itemsTotal = 0;
+    uint64_t files = 0;
+    double seconds = 0;
+};
+
+ProgressSnapshot GetCommandProgress();
+
+// "12/40 items, 7 files, 310 items/s, 1.3 s"; parts that are zero are left out.
+std::string FormatProgress(const ProgressSnapshot& progress);
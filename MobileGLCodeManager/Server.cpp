@@ -0,0 +1,241 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_set>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#include "Commands.h"
+#include "FileWatcher.h"
+#include "Server.h"
+
+// Protocol: a client sends one command per line, exactly as typed at the prompt.
+// For every line the server answers with the command's stdout/stderr output,
+// followed by a status line made of SERVER_STATUS_MARKER and the CommandStatus
+// code in decimal. Sending "quit" (or "exit") closes the connection only.
+
+#ifdef _WIN32
+
+int CMD_serve(const std::vector<std::string>& args) {
+    std::cerr << "serve is only supported on POSIX systems" << std::endl;
+    return COMMAND_FAILED;
+}
+
+#else
+
+static std::atomic<bool> serverStopping{ false };
+
+// Commands share files, caches and std::cout, so they run one at a time.
+static std::mutex commandMutex;
+
+static void HandleStopSignal(int) {
+    serverStopping = true;
+}
+
+static bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static std::string ExecuteCapturing(const std::string& line) {
+    std::lock_guard<std::mutex> lock(commandMutex);
+
+    std::ostringstream output;
+    std::streambuf* coutBuffer = std::cout.rdbuf(output.rdbuf());
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(output.rdbuf());
+    int status = COMMAND_OK;
+    try {
+        auto tokens = split(line);
+        if (!tokens.empty()) {
+            status = RunCommand(tokens);
+        }
+    }
+    catch (const std::exception& e) {
+        output << "Error: " << e.what() << std::endl;
+        status = COMMAND_FAILED;
+    }
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+
+    std::string response = output.str();
+    response += SERVER_STATUS_MARKER;
+    response += std::to_string(status);
+    response += '\n';
+    return response;
+}
+
+// Returns when the client disconnects or the server stops; the caller closes fd.
+static void ServeClient(int fd) {
+    std::string pending;
+    char buffer[4096];
+    while (!serverStopping) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer, static_cast<size_t>(n));
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            auto tokens = split(line);
+            if (!tokens.empty() && (tokens[0] == "quit" || tokens[0] == "exit")) {
+                return;
+            }
+            std::string response;
+            if (!tokens.empty() && tokens[0] == "serve") {
+                response = std::string("serve cannot be nested\n") + SERVER_STATUS_MARKER + std::to_string(COMMAND_USAGE_ERROR) + "\n";
+            } else {
+                response = ExecuteCapturing(line);
+            }
+            if (!SendAll(fd, response)) {
+                return;
+            }
+        }
+    }
+}
+
+int RunServer(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return COMMAND_FAILED;
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "Cannot create socket: " << strerror(errno) << std::endl;
+        return COMMAND_FAILED;
+    }
+
+    // A socket left behind by an earlier server is replaced; anything else at the
+    // path (a mistyped file name, say) is left alone.
+    struct stat existing{};
+    if (lstat(socketPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "Cannot listen on " << socketPath << ": the path exists and is not a socket" << std::endl;
+            close(listenFd);
+            return COMMAND_FAILED;
+        }
+        unlink(socketPath.c_str());
+    }
+    // Any client can run impl, so the socket is private to the user from the moment
+    // it exists: created under a 077 umask, and its mode checked afterwards.
+    mode_t previousUmask = umask(077);
+    bool bound = bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    int bindErrno = errno;
+    umask(previousUmask);
+    if (!bound || listen(listenFd, 16) < 0) {
+        std::cerr << "Cannot listen on " << socketPath << ": " << strerror(bound ? errno : bindErrno) << std::endl;
+        close(listenFd);
+        return COMMAND_FAILED;
+    }
+    if (chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) < 0) {
+        std::cerr << "Cannot restrict access to " << socketPath << ": " << strerror(errno) << std::endl;
+        close(listenFd);
+        unlink(socketPath.c_str());
+        return COMMAND_FAILED;
+    }
+
+    serverStopping = false;
+    auto previousInt = std::signal(SIGINT, HandleStopSignal);
+    auto previousTerm = std::signal(SIGTERM, HandleStopSignal);
+    auto previousPipe = std::signal(SIGPIPE, SIG_IGN);
+
+    StartWorkspaceWatcher();
+    std::cout << "Serving on " << socketPath << " (Ctrl-C to stop)" << std::endl;
+
+    // Client threads report themselves finished and are joined on the next pass,
+    // so a long-running server does not accumulate one thread per connection.
+    std::mutex clientsMutex;
+    std::unordered_set<int> clientFds;
+    std::vector<std::thread::id> finishedClients;
+    std::vector<std::thread> clientThreads;
+    auto joinFinishedClients = [&] {
+        std::vector<std::thread::id> finished;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            finished.swap(finishedClients);
+        }
+        for (auto id : finished) {
+            auto it = std::find_if(clientThreads.begin(), clientThreads.end(), [&](const std::thread& thread) { return thread.get_id() == id; });
+            if (it == clientThreads.end()) continue;
+            it->join();
+            clientThreads.erase(it);
+        }
+    };
+
+    while (!serverStopping) {
+        joinFinishedClients();
+        pollfd pfd{ listenFd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, 200);
+        if (ready <= 0) continue;
+
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) continue;
+
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clientFds.insert(clientFd);
+        }
+        clientThreads.emplace_back([clientFd, &clientsMutex, &clientFds, &finishedClients] {
+            ServeClient(clientFd);
+            // Out of the set before it is closed, so shutdown never reaches a reused fd number.
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clientFds.erase(clientFd);
+            close(clientFd);
+            finishedClients.push_back(std::this_thread::get_id());
+        });
+    }
+
+    {
+        // Wake up clients blocked in recv so their threads can finish.
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (int fd : clientFds) shutdown(fd, SHUT_RDWR);
+    }
+    for (auto& thread : clientThreads) thread.join();
+
+    StopFileWatcher();
+    close(listenFd);
+    unlink(socketPath.c_str());
+    std::signal(SIGINT, previousInt);
+    std::signal(SIGTERM, previousTerm);
+    std::signal(SIGPIPE, previousPipe);
+
+    std::cout << "Server stopped" << std::endl;
+    return COMMAND_OK;
+}
+
+int CMD_serve(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        std::cout << "Usage: serve <socket_path>" << std::endl;
+        return COMMAND_USAGE_ERROR;
+    }
+    return RunServer(args[1]);
+}
+
+#endif
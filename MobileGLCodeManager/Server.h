@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Marks the end of one response in the serve protocol. It is followed by the
+// command's CommandStatus and a newline.
+inline constexpr const char* SERVER_STATUS_MARKER = "\x1e" "status ";
+
+// Keeps the process resident and runs commandMap commands sent over a Unix
+// domain socket. Blocks until SIGINT/SIGTERM. Commands run with std::cout and
+// std::cerr redirected to the client, so nothing else may run meanwhile: the
+// interactive prompt refuses to start it.
+int RunServer(const std::string& socketPath);
+
+int CMD_serve(const std::vector<std::string>& args);
@@ -0,0 +1,239 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <filesystem>
+
+#include "SymbolIndex.h"
+#include "ComponentScanner.h"
+#include "FileUtils.h"
+#include "FileWatcher.h"
+#include "Instrumentation.h"
+#include "Progress.h"
+#include "ThreadPool.h"
+#include "WorkspaceCache.h"
+
+namespace fs = std::filesystem;
+
+const std::vector<SymbolLocation>& SymbolIndex::Find(const std::string& name) const {
+    static const std::vector<SymbolLocation> none;
+    auto it = locationsByName.find(name);
+    return it == locationsByName.end() ? none : it->second;
+}
+
+const ComponentSymbolSet* SymbolIndex::Symbols(const std::string& component) const {
+    auto it = components.find(component);
+    return it == components.end() ? nullptr : &it->second;
+}
+
+std::vector<std::string> SymbolIndex::Components() const {
+    std::vector<std::string> names;
+    names.reserve(components.size());
+    for (const auto& kv : components) names.push_back(kv.first);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void SymbolIndex::Forget(const std::string& component, const ComponentSymbolSet& symbols) {
+    auto forgetName = [&](const std::string& name) {
+        auto it = locationsByName.find(name);
+        if (it == locationsByName.end()) return;
+        std::erase_if(it->second, [&](const SymbolLocation& location) { return location.component == component; });
+        if (it->second.empty()) locationsByName.erase(it);
+    };
+    for (const auto& name : symbols.declared) forgetName(name);
+    for (const auto& name : symbols.defined) forgetName(name);
+}
+
+void SymbolIndex::SetComponent(const std::string& component, ComponentSymbolSet symbols) {
+    auto existing = components.find(component);
+    if (existing != components.end()) Forget(component, existing->second);
+
+    auto locate = [&](const std::string& name) -> SymbolLocation& {
+        auto& locations = locationsByName[name];
+        for (auto& location : locations) {
+            if (location.component == component) return location;
+        }
+        // Kept sorted by component so messages list them in a stable order.
+        auto pos = std::lower_bound(locations.begin(), locations.end(), component, [](const SymbolLocation& location, const std::string& value) {
+            return location.component < value;
+        });
+        return *locations.insert(pos, SymbolLocation{ component });
+    };
+    for (const auto& name : symbols.declared) locate(name).declared = true;
+    for (const auto& name : symbols.defined) locate(name).defined = true;
+    components[component] = std::move(symbols);
+}
+
+void SymbolIndex::RemoveComponent(const std::string& component) {
+    auto it = components.find(component);
+    if (it == components.end()) return;
+    Forget(component, it->second);
+    components.erase(it);
+}
+
+struct FileState {
+    bool exists = false;
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+    uint64_t stagedVersion = 0;
+
+    bool operator==(const FileState&) const = default;
+};
+
+static FileState GetFileState(const std::string& filename) {
+    FileState state;
+    state.stagedVersion = GetStagedVersion(filename);
+    if (state.stagedVersion != 0) {
+        state.exists = true;
+        return state;
+    }
+    std::error_code ec;
+    state.size = fs::file_size(filename, ec);
+    if (ec) return FileState();
+    state.mtime = fs::last_write_time(filename, ec);
+    state.exists = !ec;
+    return state;
+}
+
+struct TrackedFile {
+    FileState state;
+    uint64_t watchVersion = 0; // 0 unless the watcher vouched for 'state'
+    bool valid = false;
+
+    // Returns true if the file may have changed since the last call.
+    bool Refresh(const std::string& filename) {
+        uint64_t version = 0;
+        bool watched = GetStagedVersion(filename) == 0 && GetWatchedFileVersion(filename, version);
+        if (watched && valid && watchVersion == version && state.stagedVersion == 0) return false;
+
+        FileState current = GetFileState(filename);
+        bool changed = !valid || !(current == state);
+        state = current;
+        watchVersion = watched ? version : 0;
+        valid = true;
+        return changed;
+    }
+};
+
+struct TrackedComponent {
+    TrackedFile header;
+    TrackedFile source;
+};
+
+static SymbolIndex symbolIndex;
+static std::unordered_map<std::string, TrackedComponent> trackedComponents;
+
+static ComponentSymbolSet ScanComponentSymbols(std::string_view header, std::string_view source) {
+    ComponentSymbolSet symbols;
+    for (const auto& symbol : ScanComponentDeclarations(header)) symbols.declared.emplace(symbol.name);
+    for (const auto& symbol : ScanComponentDefinitions(source)) symbols.defined.emplace(symbol.name);
+    return symbols;
+}
+
+static ComponentSymbolSet ReadComponentSymbols(const std::string& component, const TrackedComponent& tracked) {
+    std::string header = tracked.header.state.exists ? GetFileContent(ComponentHeaderPath(component)) : std::string();
+    std::string source = tracked.source.state.exists ? GetFileContent(ComponentSourcePath(component)) : std::string();
+    return ScanComponentSymbols(header, source);
+}
+
+// Staged files are not on disk yet, so they have no stamp the cache could check.
+static bool GetCacheStamps(const TrackedComponent& tracked, CacheStamp& header, CacheStamp& source) {
+    auto convert = [](const FileState& state, CacheStamp& stamp) {
+        if (state.stagedVersion != 0) return false;
+        stamp.exists = state.exists;
+        stamp.size = state.exists ? state.size : 0;
+        stamp.mtime = state.exists ? state.mtime.time_since_epoch().count() : 0;
+        return true;
+    };
+    return convert(tracked.header.state, header) && convert(tracked.source.state, source);
+}
+
+static bool LoadCachedSymbols(const std::string& component, const TrackedComponent& tracked, ComponentSymbolSet& symbols) {
+    CacheStamp header, source;
+    return GetCacheStamps(tracked, header, source) && LoadCachedComponent(component, header, source, symbols);
+}
+
+static void StoreCachedSymbols(const std::string& component, const TrackedComponent& tracked, const ComponentSymbolSet& symbols) {
+    CacheStamp header, source;
+    if (GetCacheStamps(tracked, header, source)) StoreComponent(component, header, source, symbols);
+}
+
+// Refreshes the stamps of one component; true if it needs rescanning.
+static bool RefreshComponent(const std::string& component, TrackedComponent& tracked) {
+    bool headerChanged = tracked.header.Refresh(ComponentHeaderPath(component));
+    bool sourceChanged = tracked.source.Refresh(ComponentSourcePath(component));
+    return headerChanged || sourceChanged || !symbolIndex.Symbols(component);
+}
+
+const SymbolIndex& GetSymbolIndex(unsigned jobs) {
+    ScopedTimer timer("GetSymbolIndex");
+
+    std::vector<std::string> components = ListComponents();
+    for (const auto& name : symbolIndex.Components()) {
+        if (!std::binary_search(components.begin(), components.end(), name)) {
+            symbolIndex.RemoveComponent(name);
+            trackedComponents.erase(name);
+        }
+    }
+
+    std::vector<std::string> changed;
+    for (const auto& component : components) {
+        TrackedComponent& tracked = trackedComponents[component];
+        if (!RefreshComponent(component, tracked)) continue;
+        ComponentSymbolSet symbols;
+        if (LoadCachedSymbols(component, tracked, symbols)) symbolIndex.SetComponent(component, std::move(symbols));
+        else changed.push_back(component);
+    }
+
+    std::vector<ComponentSymbolSet> scanned(changed.size());
+    AddProgressTotal(changed.size());
+    try {
+        ParallelFor(changed.size(), jobs, [&](size_t i) {
+            ThrowIfCancelled();
+            scanned[i] = ReadComponentSymbols(changed[i], trackedComponents.at(changed[i]));
+            AddProgressDone();
+        });
+    }
+    catch (...) {
+        // The stamps were refreshed already; forget them so the next call rescans.
+        for (const auto& component : changed) {
+            trackedComponents[component].header.valid = false;
+            trackedComponents[component].source.valid = false;
+        }
+        throw;
+    }
+    for (size_t i = 0; i < changed.size(); ++i) {
+        StoreCachedSymbols(changed[i], trackedComponents.at(changed[i]), scanned[i]);
+        symbolIndex.SetComponent(changed[i], std::move(scanned[i]));
+    }
+    return symbolIndex;
+}
+
+const ComponentSymbolSet& GetComponentSymbols(const std::string& component) {
+    TrackedComponent& tracked = trackedComponents[component];
+    if (RefreshComponent(component, tracked)) {
+        ComponentSymbolSet symbols;
+        if (!LoadCachedSymbols(component, tracked, symbols)) {
+            symbols = ReadComponentSymbols(component, tracked);
+            StoreCachedSymbols(component, tracked, symbols);
+        }
+        symbolIndex.SetComponent(component, std::move(symbols));
+    }
+    return *symbolIndex.Symbols(component);
+}
+
+void UpdateComponentSymbols(const std::string& component, std::string_view header, std::string_view source) {
+    TrackedComponent& tracked = trackedComponents[component];
+    tracked.header.valid = false;
+    tracked.source.valid = false;
+    tracked.header.Refresh(ComponentHeaderPath(component));
+    tracked.source.Refresh(ComponentSourcePath(component));
+    // Our own writes show up as watcher events; re-stat once instead of rescanning.
+    tracked.header.watchVersion = 0;
+    tracked.source.watchVersion = 0;
+    ComponentSymbolSet symbols = ScanComponentSymbols(header, source);
+    StoreCachedSymbols(component, tracked, symbols);
+    symbolIndex.SetComponent(component, std::move(symbols));
+}
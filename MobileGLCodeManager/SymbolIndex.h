@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Functions a component already has.
+struct ComponentSymbolSet {
+    std::unordered_set<std::string> declared; // in GL_<component>.h
+    std::unordered_set<std::string> defined;  // in GL_<component>.cpp
+};
+
+struct SymbolLocation {
+    std::string component;
+    bool declared = false;
+    bool defined = false;
+};
+
+// Which components declare or define each function.
+class SymbolIndex {
+public:
+    // Every component that declares or defines 'name'; empty if none does.
+    const std::vector<SymbolLocation>& Find(const std::string& name) const;
+    // nullptr if the component is not indexed.
+    const ComponentSymbolSet* Symbols(const std::string& component) const;
+    std::vector<std::string> Components() const;
+
+    // Replaces everything known about one component.
+    void SetComponent(const std::string& component, ComponentSymbolSet symbols);
+    void RemoveComponent(const std::string& component);
+
+private:
+    void Forget(const std::string& component, const ComponentSymbolSet& symbols);
+
+    std::unordered_map<std::string, ComponentSymbolSet> components;
+    std::unordered_map<std::string, std::vector<SymbolLocation>> locationsByName;
+};
+
+// Session-wide index over all components. A component is rescanned only when its
+// header or source changes size, modification time or staged content; while the
+// file watcher covers them, unchanged files are not even stat'ed. Changed
+// components are rescanned on up to 'jobs' threads.
+const SymbolIndex& GetSymbolIndex(unsigned jobs = 1);
+
+// Same, but brings only one component up to date.
+const ComponentSymbolSet& GetComponentSymbols(const std::string& component);
+
+// Re-indexes a component from content we just wrote, so our own writes do not
+// force a re-read on the next lookup.
+void UpdateComponentSymbols(const std::string& component, std::string_view header, std::string_view source);
@@ -0,0 +1,224 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <regex>
+#include <cstring>
+
+#include "DefinitionIndex.h"
+#include "DefinitionScanner.h"
+
+// Checks DefinitionScanner and DefinitionIndex against the std::regex patterns
+// they replaced. Run by ctest; exits non-zero if any check fails.
+
+static size_t failures = 0;
+
+static void Check(bool condition, const std::string& what) {
+    if (condition) return;
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failures;
+}
+
+template <typename T, typename U>
+static void CheckEqual(const T& actual, const U& expected, const std::string& what) {
+    std::ostringstream message;
+    message << what << ": got '" << actual << "', expected '" << expected << "'";
+    Check(actual == expected, message.str());
+}
+
+// What the regexes found for one function.
+struct RegexEntry {
+    size_t line = 0;
+    bool isStub = false;
+    std::string returnType;
+    std::string name;
+    std::string params;
+};
+
+// The previous lookup: the line matching SetFunctionStub's HEAD...END pattern,
+// and the signature WriteSourceAndHeaderFiles read from it once it was no longer
+// a stub.
+static bool FindWithRegexes(const std::string& content, const std::string& name, RegexEntry& found) {
+    std::regex entryPattern(
+        "(DECLARE_GL_FUNCTION_(?:STUB_)?HEAD\\([^)]*\\b" + name +
+        "\\b[^)]*\\)\\s*DECLARE_GL_FUNCTION_(?:STUB_)?(?:END|END_NO_RETURN)[^)]*\\([^)]*\\b" + name + "\\b[^)]*\\))");
+    std::regex signaturePattern("DECLARE_GL_FUNCTION_HEAD\\(([^)]*\\b" + name + "\\b[^)]*)\\)");
+
+    std::istringstream stream(content);
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(stream, line)) {
+        ++lineNumber;
+        if (!std::regex_search(line, entryPattern)) continue;
+
+        found.line = lineNumber;
+        found.isStub = line.find("DECLARE_GL_FUNCTION_STUB_HEAD") != std::string::npos;
+        size_t pos = line.find("DECLARE_GL_FUNCTION_STUB_HEAD");
+        if (pos != std::string::npos) line.replace(pos, strlen("DECLARE_GL_FUNCTION_STUB_HEAD"), "DECLARE_GL_FUNCTION_HEAD");
+
+        std::smatch match;
+        if (!std::regex_search(line, match, signaturePattern)) return false;
+        std::istringstream signature(match[1].str());
+        std::vector<std::string> parts;
+        std::string part;
+        while (std::getline(signature, part, ',')) parts.push_back(part);
+        if (parts.size() < 2) return false;
+        found.returnType = parts[0];
+        found.name = parts[1].substr(1);
+        found.params.clear();
+        for (size_t i = 2; i < parts.size(); ++i) {
+            if (!found.params.empty()) found.params += ", ";
+            found.params += parts[i].substr(1);
+        }
+        return true;
+    }
+    return false;
+}
+
+static std::string JoinParams(const std::vector<std::string_view>& params) {
+    std::string joined;
+    for (auto param : params) {
+        if (!joined.empty()) joined += ", ";
+        joined += param;
+    }
+    return joined;
+}
+
+static const char* PARAM_TYPES[] = { "GLenum target", "GLuint index", "const GLfloat* v", "GLsizei count", "const void* data" };
+static const char* RETURN_TYPES[] = { "void", "GLboolean", "GLuint", "const GLubyte*" };
+
+// Every combination of STUB_/plain HEAD, STUB_/plain END and END/END_NO_RETURN,
+// with zero to three parameters, on one line each as in Definitions.cpp.
+static std::string GenerateDefinitions(std::vector<std::string>& names) {
+    std::string content = "#include \"Definitions.h\"\n\n";
+    for (size_t i = 0; i < 64; ++i) {
+        std::string name = "glTestFunction" + std::to_string(i);
+        std::string returnType = RETURN_TYPES[i % std::size(RETURN_TYPES)];
+        std::string params;
+        std::string args;
+        for (size_t p = 0; p < (i / 8) % 4; ++p) {
+            std::string param = PARAM_TYPES[(i + p) % std::size(PARAM_TYPES)] + std::to_string(p);
+            params += ", " + param;
+            args += ", " + param.substr(param.rfind(' ') + 1);
+        }
+        std::string head = (i & 1) ? "DECLARE_GL_FUNCTION_STUB_HEAD" : "DECLARE_GL_FUNCTION_HEAD";
+        std::string end = (i & 2) ? "DECLARE_GL_FUNCTION_STUB_" : "DECLARE_GL_FUNCTION_";
+        end += (i & 4) ? "END_NO_RETURN" : "END";
+        content += head + "(" + returnType + ", " + name + params + ") " + end + "(" + name + args + ")\n";
+        if (i % 5 == 0) content += "\n// " + name + " above\n";
+        names.push_back(name);
+    }
+    return content;
+}
+
+static void TestMatchesRegexes() {
+    std::vector<std::string> names;
+    std::string content = GenerateDefinitions(names);
+    DefinitionIndex index;
+    index.Build(content);
+    CheckEqual(index.Entries().size(), names.size(), "entry count");
+
+    for (const auto& name : names) {
+        RegexEntry expected;
+        Check(FindWithRegexes(content, name, expected), "regexes find " + name);
+        const DefinitionEntry* entry = index.Find(name);
+        Check(entry != nullptr, "index finds " + name);
+        if (!entry) continue;
+        CheckEqual(entry->firstLine, expected.line, name + " line");
+        CheckEqual(entry->isStub, expected.isStub, name + " stub");
+        CheckEqual(entry->returnType, expected.returnType, name + " return type");
+        CheckEqual(entry->name, expected.name, name + " name");
+        CheckEqual(JoinParams(entry->params), expected.params, name + " params");
+    }
+}
+
+// SetFunctionStub's regex rewrite of each line against SetFunctionStubsInContent.
+static void TestStubFlipMatchesRegexes() {
+    std::vector<std::string> names;
+    std::string content = GenerateDefinitions(names);
+    for (bool isStub : { false, true }) {
+        std::string expected = content;
+        for (const auto& name : names) {
+            std::istringstream stream(expected);
+            std::string rewritten;
+            std::string line;
+            std::regex entryPattern("(DECLARE_GL_FUNCTION_(?:STUB_)?HEAD\\([^)]*\\b" + name +
+                "\\b[^)]*\\)\\s*DECLARE_GL_FUNCTION_(?:STUB_)?(?:END|END_NO_RETURN)[^)]*\\([^)]*\\b" + name + "\\b[^)]*\\))");
+            while (std::getline(stream, line)) {
+                if (std::regex_search(line, entryPattern)) {
+                    const char* stubMacros[] = { "DECLARE_GL_FUNCTION_STUB_HEAD", "DECLARE_GL_FUNCTION_STUB_END" };
+                    const char* plainMacros[] = { "DECLARE_GL_FUNCTION_HEAD", "DECLARE_GL_FUNCTION_END" };
+                    for (size_t k = 0; k < 2; ++k) {
+                        const char* search = isStub ? plainMacros[k] : stubMacros[k];
+                        const char* replacement = isStub ? stubMacros[k] : plainMacros[k];
+                        size_t pos = line.find(search);
+                        if (pos != std::string::npos) line.replace(pos, strlen(search), replacement);
+                    }
+                }
+                rewritten += line + "\n";
+            }
+            expected = rewritten;
+        }
+
+        DefinitionIndex index;
+        index.Build(content);
+        std::vector<const DefinitionEntry*> entries;
+        for (const auto& entry : index.Entries()) entries.push_back(&entry);
+        std::string actual = index.Content();
+        SetFunctionStubsInContent(actual, entries, isStub);
+        Check(actual == expected, std::string("stub flip to ") + (isStub ? "stub" : "implemented") + " matches the regex rewrite");
+    }
+}
+
+// The regexes stopped at the first ')', which cut function pointer parameters short.
+static void TestParenthesisInParameterType() {
+    std::string content =
+        "DECLARE_GL_FUNCTION_STUB_HEAD(void, glDebugMessageCallback, void (*callback)(GLenum source, GLuint id), const void* userParam) "
+        "DECLARE_GL_FUNCTION_STUB_END_NO_RETURN(glDebugMessageCallback, callback, userParam)\n"
+        "DECLARE_GL_FUNCTION_HEAD(GLboolean, glIsTexture, GLuint texture) DECLARE_GL_FUNCTION_END(glIsTexture, texture)\n";
+    DefinitionIndex index;
+    index.Build(content);
+    CheckEqual(index.Entries().size(), size_t(2), "entries with a function pointer parameter");
+
+    const DefinitionEntry* entry = index.Find("glDebugMessageCallback");
+    Check(entry != nullptr, "index finds glDebugMessageCallback");
+    if (entry) {
+        CheckEqual(entry->params.size(), size_t(2), "glDebugMessageCallback parameter count");
+        CheckEqual(JoinParams(entry->params), "void (*callback)(GLenum source, GLuint id), const void* userParam", "glDebugMessageCallback params");
+        CheckEqual(entry->isStub, true, "glDebugMessageCallback stub");
+        CheckEqual(entry->firstLine, size_t(1), "glDebugMessageCallback line");
+    }
+    RegexEntry old;
+    Check(!FindWithRegexes(content, "glDebugMessageCallback", old), "regexes miss glDebugMessageCallback");
+
+    // The entry after it is unaffected, and agrees with the regexes.
+    RegexEntry expected;
+    Check(FindWithRegexes(content, "glIsTexture", expected), "regexes find glIsTexture");
+    entry = index.Find("glIsTexture");
+    Check(entry != nullptr, "index finds glIsTexture");
+    if (entry) {
+        CheckEqual(entry->firstLine, expected.line, "glIsTexture line");
+        CheckEqual(JoinParams(entry->params), expected.params, "glIsTexture params");
+    }
+
+    GLMacroToken token;
+    DefinitionScanner scanner(content);
+    Check(scanner.Next(token) && token.kind == GLMacroKind::Head && token.isStub, "scanner reads the stub HEAD");
+    Check(scanner.Next(token) && token.kind == GLMacroKind::EndNoReturn && token.isStub, "scanner reads the stub END_NO_RETURN");
+    Check(scanner.Next(token) && token.kind == GLMacroKind::Head && !token.isStub, "scanner reads the HEAD");
+    Check(scanner.Next(token) && token.kind == GLMacroKind::End && !token.isStub && scanner.Line() == 2, "scanner reads the END on line 2");
+    Check(!scanner.Next(token), "scanner stops at the end");
+}
+
+int main() {
+    TestMatchesRegexes();
+    TestStubFlipMatchesRegexes();
+    TestParenthesisInParameterType();
+    if (failures != 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
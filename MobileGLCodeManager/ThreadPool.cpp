@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    threadCount = std::max(1u, threadCount);
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return tasks.empty() && activeTasks == 0; });
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++activeTasks;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeTasks;
+            if (tasks.empty() && activeTasks == 0) allDone.notify_all();
+        }
+    }
+}
+
+unsigned HardwareJobCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ParallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& body) {
+    if (jobs <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+    std::atomic<size_t> next{ 0 };
+
+    ThreadPool pool(static_cast<unsigned>(std::min<size_t>(jobs, count)));
+    for (unsigned worker = 0; worker < pool.Size(); ++worker) {
+        pool.Submit([&] {
+            for (size_t i = next++; i < count; i = next++) {
+                try {
+                    body(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!firstError) firstError = std::current_exception();
+                }
+            }
+        });
+    }
+    pool.Wait();
+
+    if (firstError) std::rethrow_exception(firstError);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed-size pool of worker threads that run queued tasks in FIFO order.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Tasks must not throw; catch inside the task and report through its result.
+    void Submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished.
+    void Wait();
+
+    unsigned Size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    size_t activeTasks = 0;
+    bool stopping = false;
+};
+
+// Number of hardware threads, at least 1.
+unsigned HardwareJobCount();
+
+// Runs body(i) for every i in [0, count) on up to 'jobs' threads. Runs inline
+// when jobs <= 1. The first exception thrown by a body is rethrown after all
+// iterations have finished.
+void ParallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& body);
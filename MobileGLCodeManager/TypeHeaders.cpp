@@ -0,0 +1,139 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#include "TypeHeaders.h"
+#include "DefinitionScanner.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+
+namespace fs = std::filesystem;
+
+const char* TYPE_HEADERS_FILE_PATH = "CodeManagerTemplates/type_headers.txt";
+
+static bool IsIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static bool IsQualifier(std::string_view word) {
+    return word == "const" || word == "volatile" || word == "struct" || word == "enum" || word == "class" || word == "union";
+}
+
+static bool IsBuiltinType(std::string_view word) {
+    for (std::string_view builtin : { "void", "bool", "char", "short", "int", "long", "float", "double", "signed", "unsigned" }) {
+        if (word == builtin) return true;
+    }
+    return false;
+}
+
+std::vector<std::string_view> TypeNamesIn(std::string_view declaration, bool isParameter) {
+    declaration = declaration.substr(0, declaration.find('['));
+
+    // Identifiers, with "::" kept inside qualified names.
+    std::vector<std::string_view> words;
+    size_t declaratorName = std::string_view::npos; // "void (*name)(GLenum)"
+    for (size_t i = 0; i < declaration.size();) {
+        if (!IsIdentifierChar(declaration[i])) {
+            if (declaration[i] == ')' && declaratorName == std::string_view::npos && !words.empty()) declaratorName = words.size() - 1;
+            ++i;
+            continue;
+        }
+        size_t begin = i;
+        while (i < declaration.size() && (IsIdentifierChar(declaration[i]) || declaration.substr(i, 2) == "::")) {
+            i += declaration.substr(i, 2) == "::" ? 2 : 1;
+        }
+        if (declaration[begin] >= '0' && declaration[begin] <= '9') continue;
+        words.push_back(declaration.substr(begin, i - begin));
+    }
+
+    if (isParameter && !words.empty()) {
+        if (declaratorName != std::string_view::npos) {
+            words.erase(words.begin() + declaratorName);
+        } else {
+            // The last word names the parameter if a type comes before it: not in "const GLenum".
+            bool typeBefore = std::any_of(words.begin(), words.end() - 1, [](std::string_view word) { return !IsQualifier(word); });
+            if (typeBefore && !IsQualifier(words.back()) && !IsBuiltinType(words.back())) words.pop_back();
+        }
+    }
+
+    std::vector<std::string_view> types;
+    for (std::string_view word : words) {
+        if (!IsQualifier(word) && !IsBuiltinType(word)) types.push_back(word);
+    }
+    return types;
+}
+
+TypeHeaderMap TypeHeaderMap::Parse(std::string_view text, const std::string& origin) {
+    TypeHeaderMap map;
+    size_t lineStart = 0;
+    size_t lineNumber = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+
+        line = TrimWhitespace(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        size_t split = line.find_first_of(" \t");
+        std::string_view header = split == std::string_view::npos ? std::string_view() : TrimWhitespace(line.substr(split));
+        bool quoted = header.size() > 2 && ((header.front() == '<' && header.back() == '>') || (header.front() == '"' && header.back() == '"'));
+        if (!quoted || header.find_first_of(" \t") != std::string_view::npos) {
+            throw std::runtime_error("Invalid type mapping at " + origin + ":" + std::to_string(lineNumber) +
+                ", expected '<type> <header>' or '<type> \"header\"'");
+        }
+
+        std::string_view type = line.substr(0, split);
+        if (type == "*") map.defaultHeader = header;
+        else map.headerByType[std::string(type)] = header;
+    }
+    return map;
+}
+
+const std::string& TypeHeaderMap::HeaderFor(std::string_view type) const {
+    auto it = headerByType.find(std::string(type));
+    return it == headerByType.end() ? defaultHeader : it->second;
+}
+
+std::vector<std::string> TypeHeaderMap::HeadersFor(std::string_view returnType, const std::vector<std::string_view>& params) const {
+    std::vector<std::string> headers;
+    for (std::string_view type : TypeNamesIn(returnType, false)) headers.push_back(HeaderFor(type));
+    for (std::string_view param : params) {
+        for (std::string_view type : TypeNamesIn(param, true)) headers.push_back(HeaderFor(type));
+    }
+    std::sort(headers.begin(), headers.end());
+    headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+    return headers;
+}
+
+struct CachedTypeHeaderMap {
+    std::shared_ptr<const TypeHeaderMap> map;
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+};
+
+std::shared_ptr<const TypeHeaderMap> LoadTypeHeaderMap() {
+    static std::mutex mutex;
+    static CachedTypeHeaderMap cached;
+
+    std::error_code ec;
+    uintmax_t size = fs::file_size(TYPE_HEADERS_FILE_PATH, ec);
+    if (ec) return nullptr;
+    fs::file_time_type mtime = fs::last_write_time(TYPE_HEADERS_FILE_PATH, ec);
+    if (ec) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cached.map && cached.size == size && cached.mtime == mtime) return cached.map;
+
+    ScopedTimer timer("LoadTypeHeaderMap");
+    cached.map = std::make_shared<const TypeHeaderMap>(TypeHeaderMap::Parse(ReadFileFromDisk(TYPE_HEADERS_FILE_PATH), TYPE_HEADERS_FILE_PATH));
+    cached.size = size;
+    cached.mtime = mtime;
+    return cached.map;
+}
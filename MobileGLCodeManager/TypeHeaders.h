@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// Workspace file mapping types to the headers that declare them, one
+// "<type> <header>" per line, e.g. "GLenum <GLES3/gl32.h>" ('#' starts a
+// comment). "* <header>" names the header for types the map does not list;
+// it defaults to <Includes.h>. While the file exists, generated component
+// headers include only what their declarations use.
+extern const char* TYPE_HEADERS_FILE_PATH;
+
+class TypeHeaderMap {
+public:
+    // Throws std::runtime_error naming 'origin' on a malformed line.
+    static TypeHeaderMap Parse(std::string_view text, const std::string& origin);
+
+    // "<header>" or "\"header\"", as written in the map.
+    const std::string& HeaderFor(std::string_view type) const;
+    const std::string& DefaultHeader() const { return defaultHeader; }
+
+    // Headers needed to declare a function with this signature, sorted and
+    // without duplicates. Builtin types need none.
+    std::vector<std::string> HeadersFor(std::string_view returnType, const std::vector<std::string_view>& params) const;
+
+private:
+    std::unordered_map<std::string, std::string> headerByType;
+    std::string defaultHeader = "<Includes.h>";
+};
+
+// The workspace map, reparsed only when the file changes; nullptr if there is none.
+std::shared_ptr<const TypeHeaderMap> LoadTypeHeaderMap();
+
+// Names of the types in a return type or parameter declaration, without
+// qualifiers, builtin types or the parameter name: "const GLfloat* v" -> GLfloat.
+std::vector<std::string_view> TypeNamesIn(std::string_view declaration, bool isParameter);
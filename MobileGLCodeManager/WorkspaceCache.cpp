@@ -0,0 +1,524 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <memory>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "WorkspaceCache.h"
+#include "ComponentScanner.h"
+#include "DefinitionIndex.h"
+#include "FileUtils.h"
+#include "Instrumentation.h"
+#include "SymbolIndex.h"
+
+namespace fs = std::filesystem;
+
+const char* WORKSPACE_CACHE_FILE_PATH = ".mgcm_cache";
+
+// Bump whenever a record layout or the parsers change.
+static constexpr uint32_t CACHE_VERSION = 1;
+static constexpr char CACHE_MAGIC[8] = { 'M', 'G', 'C', 'M', 'I', 'D', 'X', '\0' };
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// File layout: CacheHeader, then the sections it points to. Every record is a
+// multiple of 8 bytes and every section starts 8-aligned, so records are read
+// straight from the mapping.
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t payloadSize; // bytes after the header
+    uint64_t payloadHash; // HashContent of those bytes
+    uint64_t definitionsOffset; // from the start of the file; 0 if absent
+    uint64_t componentsOffset;
+};
+
+struct CachedSpan {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct CachedStamp {
+    uint64_t size;
+    int64_t mtime;
+    uint32_t exists;
+    uint32_t reserved;
+};
+
+// Followed by CachedDefinition[entryCount], CachedSpan[paramCount] and the
+// string pool. Names, return types and parameters are spans of the definitions
+// content itself; only 'path' is in the pool.
+struct CachedDefinitionsHeader {
+    CachedStamp stamp;
+    uint64_t contentHash;
+    CachedSpan path;
+    uint32_t entryCount;
+    uint32_t paramCount;
+    uint32_t stringsSize;
+    uint32_t reserved;
+};
+
+struct CachedDefinition {
+    CachedSpan name;
+    CachedSpan returnType;
+    uint32_t firstParam;
+    uint32_t paramCount;
+    uint32_t firstLine;
+    uint32_t lastLine;
+    uint32_t headOffset;
+    uint32_t endOffset;
+    uint32_t isStub;
+    uint32_t reserved;
+};
+
+// Followed by CachedComponent[componentCount], CachedSpan[nameCount] and the
+// string pool every span points into.
+struct CachedComponentsHeader {
+    uint32_t componentCount;
+    uint32_t nameCount;
+    uint32_t stringsSize;
+    uint32_t reserved;
+};
+
+struct CachedComponent {
+    CachedSpan name;
+    CachedStamp header;
+    CachedStamp source;
+    uint32_t firstDeclared;
+    uint32_t declaredCount;
+    uint32_t firstDefined;
+    uint32_t definedCount;
+};
+
+static_assert(std::is_trivially_copyable_v<CacheHeader> && sizeof(CacheHeader) % 8 == 0);
+static_assert(sizeof(CachedDefinitionsHeader) % 8 == 0 && sizeof(CachedDefinition) % 8 == 0);
+static_assert(sizeof(CachedComponentsHeader) % 8 == 0 && sizeof(CachedComponent) % 8 == 0);
+
+uint64_t HashContent(std::string_view content) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ content.size();
+    size_t i = 0;
+    for (; i + 8 <= content.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, content.data() + i, 8);
+        h = (h ^ word) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, content.data() + i, content.size() - i);
+    h = (h ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 29;
+    return h;
+}
+
+CacheStamp GetCacheStamp(const std::string& filename) {
+    CacheStamp stamp;
+    std::error_code ec;
+    auto size = fs::file_size(filename, ec);
+    if (ec) return stamp;
+    auto mtime = fs::last_write_time(filename, ec);
+    if (ec) return stamp;
+    stamp.exists = true;
+    stamp.size = size;
+    stamp.mtime = mtime.time_since_epoch().count();
+    return stamp;
+}
+
+static bool SameStamp(const CachedStamp& cached, const CacheStamp& stamp) {
+    if (!stamp.exists) return cached.exists == 0;
+    return cached.exists != 0 && cached.size == stamp.size && cached.mtime == stamp.mtime;
+}
+
+static CachedStamp ToCachedStamp(const CacheStamp& stamp) {
+    CachedStamp cached{};
+    cached.exists = stamp.exists ? 1 : 0;
+    cached.size = stamp.exists ? stamp.size : 0;
+    cached.mtime = stamp.exists ? stamp.mtime : 0;
+    return cached;
+}
+
+// The cache file as it was when first needed this session, checked once.
+class MappedCache {
+public:
+    MappedCache() { Map(); }
+    ~MappedCache() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<char*>(data), size);
+#endif
+    }
+    MappedCache(const MappedCache&) = delete;
+    MappedCache& operator=(const MappedCache&) = delete;
+
+    const CachedDefinitionsHeader* definitions = nullptr;
+    const CachedDefinition* definitionEntries = nullptr;
+    const CachedSpan* definitionParams = nullptr;
+    const char* definitionStrings = nullptr;
+
+    const CachedComponentsHeader* components = nullptr;
+    const CachedComponent* componentEntries = nullptr;
+    const CachedSpan* componentNames = nullptr;
+    const char* componentStrings = nullptr;
+
+    std::string_view ComponentString(const CachedSpan& span) const {
+        return std::string_view(componentStrings + span.offset, span.length);
+    }
+    const CachedComponent* FindComponent(std::string_view name) const {
+        auto it = componentByName.find(name);
+        return it == componentByName.end() ? nullptr : &componentEntries[it->second];
+    }
+
+private:
+    void Map() {
+#ifdef _WIN32
+        try {
+            if (!IsFileExists(WORKSPACE_CACHE_FILE_PATH)) return;
+            std::string content = ReadFileFromDisk(WORKSPACE_CACHE_FILE_PATH);
+            buffer.resize((content.size() + 7) / 8);
+            std::memcpy(buffer.data(), content.data(), content.size());
+            data = reinterpret_cast<const char*>(buffer.data());
+            size = content.size();
+        }
+        catch (const std::exception&) {
+            return;
+        }
+#else
+        int fd = open(WORKSPACE_CACHE_FILE_PATH, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(CacheHeader))) {
+            void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                data = static_cast<const char*>(mapping);
+                size = static_cast<size_t>(st.st_size);
+                mapped = true;
+            }
+        }
+        close(fd);
+#endif
+        if (!Validate()) {
+            definitions = nullptr;
+            components = nullptr;
+        }
+    }
+
+    // Bounds of a section of 'count' records starting at 'offset'.
+    bool Fits(uint64_t offset, uint64_t bytes) const {
+        return offset <= size && bytes <= size - offset;
+    }
+
+    bool Validate() {
+        ScopedTimer timer("ValidateWorkspaceCache");
+        if (!data || size < sizeof(CacheHeader)) return false;
+        const auto* header = reinterpret_cast<const CacheHeader*>(data);
+        if (std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header->version != CACHE_VERSION ||
+            header->byteOrder != BYTE_ORDER_MARK || header->payloadSize != size - sizeof(CacheHeader)) {
+            return false;
+        }
+        if (HashContent(std::string_view(data + sizeof(CacheHeader), header->payloadSize)) != header->payloadHash) return false;
+
+        if (uint64_t offset = header->definitionsOffset) {
+            if (offset % 8 != 0 || !Fits(offset, sizeof(CachedDefinitionsHeader))) return false;
+            definitions = reinterpret_cast<const CachedDefinitionsHeader*>(data + offset);
+            offset += sizeof(CachedDefinitionsHeader);
+            uint64_t entriesBytes = uint64_t(definitions->entryCount) * sizeof(CachedDefinition);
+            uint64_t paramsBytes = uint64_t(definitions->paramCount) * sizeof(CachedSpan);
+            if (!Fits(offset, entriesBytes + paramsBytes + definitions->stringsSize)) return false;
+            definitionEntries = reinterpret_cast<const CachedDefinition*>(data + offset);
+            definitionParams = reinterpret_cast<const CachedSpan*>(data + offset + entriesBytes);
+            definitionStrings = data + offset + entriesBytes + paramsBytes;
+            if (uint64_t(definitions->path.offset) + definitions->path.length > definitions->stringsSize) return false;
+            for (uint32_t i = 0; i < definitions->entryCount; ++i) {
+                const CachedDefinition& entry = definitionEntries[i];
+                if (uint64_t(entry.firstParam) + entry.paramCount > definitions->paramCount) return false;
+            }
+        }
+
+        if (uint64_t offset = header->componentsOffset) {
+            if (offset % 8 != 0 || !Fits(offset, sizeof(CachedComponentsHeader))) return false;
+            components = reinterpret_cast<const CachedComponentsHeader*>(data + offset);
+            offset += sizeof(CachedComponentsHeader);
+            uint64_t entriesBytes = uint64_t(components->componentCount) * sizeof(CachedComponent);
+            uint64_t namesBytes = uint64_t(components->nameCount) * sizeof(CachedSpan);
+            if (!Fits(offset, entriesBytes + namesBytes + components->stringsSize)) return false;
+            componentEntries = reinterpret_cast<const CachedComponent*>(data + offset);
+            componentNames = reinterpret_cast<const CachedSpan*>(data + offset + entriesBytes);
+            componentStrings = data + offset + entriesBytes + namesBytes;
+            auto validSpan = [&](const CachedSpan& span) { return uint64_t(span.offset) + span.length <= components->stringsSize; };
+            for (uint32_t i = 0; i < components->nameCount; ++i) {
+                if (!validSpan(componentNames[i])) return false;
+            }
+            componentByName.reserve(components->componentCount);
+            for (uint32_t i = 0; i < components->componentCount; ++i) {
+                const CachedComponent& component = componentEntries[i];
+                if (!validSpan(component.name) ||
+                    uint64_t(component.firstDeclared) + component.declaredCount > components->nameCount ||
+                    uint64_t(component.firstDefined) + component.definedCount > components->nameCount) {
+                    return false;
+                }
+                componentByName.emplace(ComponentString(component.name), i);
+            }
+        }
+        return true;
+    }
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+#ifdef _WIN32
+    std::vector<uint64_t> buffer;
+#endif
+    std::unordered_map<std::string_view, uint32_t> componentByName;
+};
+
+struct StoredComponent {
+    CacheStamp header;
+    CacheStamp source;
+    std::vector<std::string> declared;
+    std::vector<std::string> defined;
+};
+
+static std::mutex cacheMutex;
+static std::unique_ptr<MappedCache> mappedCache;
+static std::string storedDefinitionsPath;
+static const DefinitionIndex* storedDefinitions = nullptr;
+static std::unordered_map<std::string, StoredComponent> storedComponents;
+static bool cacheDirty = false;
+
+static const MappedCache& GetMappedCache() {
+    if (!mappedCache) mappedCache = std::make_unique<MappedCache>();
+    return *mappedCache;
+}
+
+bool LoadCachedDefinitions(const std::string& filename, const CacheStamp& stamp, std::string& content, DefinitionIndex& index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const MappedCache& cache = GetMappedCache();
+    const CachedDefinitionsHeader* header = cache.definitions;
+    if (!header || !SameStamp(header->stamp, stamp) || content.size() != stamp.size) return false;
+    if (std::string_view(cache.definitionStrings + header->path.offset, header->path.length) != filename) return false;
+
+    ScopedTimer timer("LoadCachedDefinitions");
+    if (HashContent(content) != header->contentHash) return false;
+
+    auto view = [&](const CachedSpan& span, std::string_view& out) {
+        if (uint64_t(span.offset) + span.length > content.size()) return false;
+        out = std::string_view(content.data() + span.offset, span.length);
+        return true;
+    };
+    std::vector<DefinitionEntry> entries(header->entryCount);
+    for (uint32_t i = 0; i < header->entryCount; ++i) {
+        const CachedDefinition& cached = cache.definitionEntries[i];
+        DefinitionEntry& entry = entries[i];
+        if (!view(cached.name, entry.name) || !view(cached.returnType, entry.returnType)) return false;
+        entry.params.resize(cached.paramCount);
+        for (uint32_t p = 0; p < cached.paramCount; ++p) {
+            if (!view(cache.definitionParams[cached.firstParam + p], entry.params[p])) return false;
+        }
+        entry.firstLine = cached.firstLine;
+        entry.lastLine = cached.lastLine;
+        entry.headOffset = cached.headOffset;
+        entry.endOffset = cached.endOffset;
+        entry.isStub = cached.isStub != 0;
+    }
+    index.Restore(std::move(content), std::move(entries));
+    return true;
+}
+
+void StoreDefinitions(const std::string& filename, const DefinitionIndex* index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    storedDefinitionsPath = filename;
+    storedDefinitions = index;
+    cacheDirty = true;
+}
+
+bool LoadCachedComponent(const std::string& component, const CacheStamp& header, const CacheStamp& source, ComponentSymbolSet& symbols) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const MappedCache& cache = GetMappedCache();
+    if (!cache.components) return false;
+    const CachedComponent* cached = cache.FindComponent(component);
+    if (!cached || !SameStamp(cached->header, header) || !SameStamp(cached->source, source)) return false;
+
+    symbols.declared.clear();
+    symbols.defined.clear();
+    symbols.declared.reserve(cached->declaredCount);
+    symbols.defined.reserve(cached->definedCount);
+    for (uint32_t i = 0; i < cached->declaredCount; ++i) {
+        symbols.declared.emplace(cache.ComponentString(cache.componentNames[cached->firstDeclared + i]));
+    }
+    for (uint32_t i = 0; i < cached->definedCount; ++i) {
+        symbols.defined.emplace(cache.ComponentString(cache.componentNames[cached->firstDefined + i]));
+    }
+    return true;
+}
+
+void StoreComponent(const std::string& component, const CacheStamp& header, const CacheStamp& source, const ComponentSymbolSet& symbols) {
+    StoredComponent stored;
+    stored.header = header;
+    stored.source = source;
+    stored.declared.assign(symbols.declared.begin(), symbols.declared.end());
+    stored.defined.assign(symbols.defined.begin(), symbols.defined.end());
+    // Sorted, so that an unchanged workspace writes an identical file.
+    std::sort(stored.declared.begin(), stored.declared.end());
+    std::sort(stored.defined.begin(), stored.defined.end());
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    storedComponents[component] = std::move(stored);
+    cacheDirty = true;
+}
+
+static void Append(std::string& out, const void* data, size_t bytes) {
+    out.append(static_cast<const char*>(data), bytes);
+}
+
+static void PadTo8(std::string& out) {
+    out.append((8 - out.size() % 8) % 8, '\0');
+}
+
+static CachedSpan AddString(std::string& pool, std::string_view text) {
+    CachedSpan span{ static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(text.size()) };
+    pool += text;
+    return span;
+}
+
+static CacheStamp FromCachedStamp(const CachedStamp& cached) {
+    return CacheStamp{ cached.exists != 0, cached.size, cached.mtime };
+}
+
+void SaveWorkspaceCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!cacheDirty) return;
+    ScopedTimer timer("SaveWorkspaceCache");
+    const MappedCache& cache = GetMappedCache();
+
+    std::string out(sizeof(CacheHeader), '\0');
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+
+    // The stored index may have been written since; only its size is checked
+    // here, a load compares the content hash.
+    CacheStamp definitionsStamp = GetCacheStamp(storedDefinitionsPath);
+    if (storedDefinitions && definitionsStamp.exists && definitionsStamp.size == storedDefinitions->Content().size()) {
+        const std::string& content = storedDefinitions->Content();
+        auto span = [&](std::string_view view) {
+            return CachedSpan{ static_cast<uint32_t>(view.data() - content.data()), static_cast<uint32_t>(view.size()) };
+        };
+        std::vector<CachedDefinition> entries;
+        std::vector<CachedSpan> params;
+        entries.reserve(storedDefinitions->Entries().size());
+        for (const auto& entry : storedDefinitions->Entries()) {
+            CachedDefinition cached{};
+            cached.name = span(entry.name);
+            cached.returnType = span(entry.returnType);
+            cached.firstParam = static_cast<uint32_t>(params.size());
+            cached.paramCount = static_cast<uint32_t>(entry.params.size());
+            for (auto param : entry.params) params.push_back(span(param));
+            cached.firstLine = static_cast<uint32_t>(entry.firstLine);
+            cached.lastLine = static_cast<uint32_t>(entry.lastLine);
+            cached.headOffset = static_cast<uint32_t>(entry.headOffset);
+            cached.endOffset = static_cast<uint32_t>(entry.endOffset);
+            cached.isStub = entry.isStub ? 1 : 0;
+            entries.push_back(cached);
+        }
+        std::string strings;
+        CachedDefinitionsHeader section{};
+        section.stamp = ToCachedStamp(definitionsStamp);
+        section.contentHash = HashContent(content);
+        section.path = AddString(strings, storedDefinitionsPath);
+        section.entryCount = static_cast<uint32_t>(entries.size());
+        section.paramCount = static_cast<uint32_t>(params.size());
+        section.stringsSize = static_cast<uint32_t>(strings.size());
+
+        header.definitionsOffset = out.size();
+        Append(out, &section, sizeof(section));
+        Append(out, entries.data(), entries.size() * sizeof(CachedDefinition));
+        Append(out, params.data(), params.size() * sizeof(CachedSpan));
+        out += strings;
+        PadTo8(out);
+    } else if (cache.definitions) {
+        // Not loaded this session; carry the section over as it is.
+        const CachedDefinitionsHeader* section = cache.definitions;
+        size_t bytes = sizeof(CachedDefinitionsHeader) + section->entryCount * sizeof(CachedDefinition) +
+            section->paramCount * sizeof(CachedSpan) + section->stringsSize;
+        header.definitionsOffset = out.size();
+        Append(out, section, bytes);
+        PadTo8(out);
+    }
+
+    // Components stored this session, plus cached ones not seen again whose
+    // files still exist; sorted by name.
+    std::vector<std::pair<std::string, StoredComponent>> components(storedComponents.begin(), storedComponents.end());
+    if (cache.components) {
+        for (uint32_t i = 0; i < cache.components->componentCount; ++i) {
+            const CachedComponent& cached = cache.componentEntries[i];
+            std::string name(cache.ComponentString(cached.name));
+            if (storedComponents.contains(name)) continue;
+            if (!IsFileExists(ComponentHeaderPath(name)) && !IsFileExists(ComponentSourcePath(name))) continue;
+            StoredComponent carried;
+            carried.header = FromCachedStamp(cached.header);
+            carried.source = FromCachedStamp(cached.source);
+            for (uint32_t n = 0; n < cached.declaredCount; ++n) {
+                carried.declared.emplace_back(cache.ComponentString(cache.componentNames[cached.firstDeclared + n]));
+            }
+            for (uint32_t n = 0; n < cached.definedCount; ++n) {
+                carried.defined.emplace_back(cache.ComponentString(cache.componentNames[cached.firstDefined + n]));
+            }
+            components.emplace_back(std::move(name), std::move(carried));
+        }
+    }
+    if (!components.empty()) {
+        std::sort(components.begin(), components.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<CachedComponent> entries;
+        std::vector<CachedSpan> names;
+        std::string strings;
+        for (const auto& [name, stored] : components) {
+            CachedComponent cached{};
+            cached.name = AddString(strings, name);
+            cached.header = ToCachedStamp(stored.header);
+            cached.source = ToCachedStamp(stored.source);
+            cached.firstDeclared = static_cast<uint32_t>(names.size());
+            cached.declaredCount = static_cast<uint32_t>(stored.declared.size());
+            for (const auto& symbol : stored.declared) names.push_back(AddString(strings, symbol));
+            cached.firstDefined = static_cast<uint32_t>(names.size());
+            cached.definedCount = static_cast<uint32_t>(stored.defined.size());
+            for (const auto& symbol : stored.defined) names.push_back(AddString(strings, symbol));
+            entries.push_back(cached);
+        }
+        CachedComponentsHeader section{};
+        section.componentCount = static_cast<uint32_t>(entries.size());
+        section.nameCount = static_cast<uint32_t>(names.size());
+        section.stringsSize = static_cast<uint32_t>(strings.size());
+
+        header.componentsOffset = out.size();
+        Append(out, &section, sizeof(section));
+        Append(out, entries.data(), entries.size() * sizeof(CachedComponent));
+        Append(out, names.data(), names.size() * sizeof(CachedSpan));
+        out += strings;
+        PadTo8(out);
+    }
+
+    header.payloadSize = out.size() - sizeof(CacheHeader);
+    header.payloadHash = HashContent(std::string_view(out).substr(sizeof(CacheHeader)));
+    std::memcpy(out.data(), &header, sizeof(header));
+    try {
+        WriteFileToDisk(WORKSPACE_CACHE_FILE_PATH, out);
+    }
+    catch (const std::exception&) {
+        // A read-only workspace just starts without a cache next time.
+    }
+    // The old mapping may no longer match the file; map the new one on next use.
+    mappedCache.reset();
+    storedComponents.clear();
+    cacheDirty = false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+class DefinitionIndex;
+struct ComponentSymbolSet;
+
+// Binary cache of parsed workspace state, so a cold start does not re-parse
+// Definitions.cpp and every component: the definitions with their stub state,
+// and the functions each component declares and defines. The file is
+// memory-mapped and its records are read in place.
+//
+// Every record carries the size and modification time of the file it came from,
+// the definitions also a hash of their content. Stale records, a corrupt or
+// truncated file, or one from another version are ignored, and callers parse
+// as if there were no cache.
+extern const char* WORKSPACE_CACHE_FILE_PATH;
+
+struct CacheStamp {
+    bool exists = false;
+    uint64_t size = 0;
+    int64_t mtime = 0; // file_time_type ticks
+};
+
+uint64_t HashContent(std::string_view content);
+// The stamp of a file on disk; 'exists' is false if it cannot be stat'ed.
+CacheStamp GetCacheStamp(const std::string& filename);
+
+// Restores 'index' from the cache if it holds the definitions of 'filename' for
+// exactly this stamp and content. On success 'content' has been moved into the index.
+bool LoadCachedDefinitions(const std::string& filename, const CacheStamp& stamp, std::string& content, DefinitionIndex& index);
+// Records freshly parsed definitions for the next SaveWorkspaceCache. The index
+// must stay alive until then. Its content may still be staged: the file is
+// stamped when the cache is saved, and a load checks the content hash anyway.
+void StoreDefinitions(const std::string& filename, const DefinitionIndex* index);
+
+bool LoadCachedComponent(const std::string& component, const CacheStamp& header, const CacheStamp& source, ComponentSymbolSet& symbols);
+void StoreComponent(const std::string& component, const CacheStamp& header, const CacheStamp& source, const ComponentSymbolSet& symbols);
+
+// Rewrites the cache file if anything was stored since it was read. Records that
+// were not stored again are carried over unless both of their files are gone.
+void SaveWorkspaceCache();
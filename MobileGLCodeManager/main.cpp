@@ -1,27 +1,48 @@
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <unordered_map>
 #include <functional>
 #include <algorithm>
+#include <cstdio>
+#include <csignal>
 
 #ifdef _WIN32
-#include <conio.h>
-#include <windows.h>
+#include <io.h>
 #else
-#include <termios.h>
 #include <unistd.h>
-#include <sys/ioctl.h>
 #endif
 
+#include "CMD_implementFunction.h"
+#include "TypeHeaders.h"
+#include "Commands.h"
+#include "CommandQueue.h"
+#include "Progress.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
+#include "LineEditor.h"
+#include "Server.h"
+#include "FileUtils.h"
+#include "FileWatcher.h"
+#include "WorkspaceCache.h"
+
 // forward declarations
-void implementFunction(const std::string& functionName, const std::string& component);
+int CMD_coverage(const std::vector<std::string>& args);
+int CMD_dispatch(const std::vector<std::string>& args);
+int CMD_profile(const std::vector<std::string>& args);
+int CMD_includes(const std::vector<std::string>& args);
+int CMD_pch(const std::vector<std::string>& args);
+int CMD_unity(const std::vector<std::string>& args);
+int CMD_verify(const std::vector<std::string>& args);
+int CMD_stage(const std::vector<std::string>& args);
+int CMD_diff(const std::vector<std::string>& args);
+int CMD_commit(const std::vector<std::string>& args);
+int CMD_discard(const std::vector<std::string>& args);
 
 static bool isProgramClosed = false;
 
-using CommandHandler = std::function<void(const std::vector<std::string>& args)>;
-
 std::unordered_map<std::string, CommandHandler> commandMap;
 
 // --- utils ---
@@ -33,354 +54,395 @@ std::vector<std::string> split(const std::string& line) {
     return tokens;
 }
 
-void CMD_help(const std::vector<std::string>& args) {
+int CMD_help(const std::vector<std::string>& args) {
     std::cout << "Available commands:" << std::endl;
     for (auto& kv : commandMap) {
         std::cout << "  " << kv.first << std::endl;
     }
+    return COMMAND_OK;
 }
 
-void CMD_exit(const std::vector<std::string>& args) {
+int CMD_exit(const std::vector<std::string>& args) {
     std::cout << "Exiting program..." << std::endl;
     isProgramClosed = true;
+    return COMMAND_OK;
 }
 
-void CMD_implementFunction(const std::vector<std::string>& args) {
-    if (args.size() < 3) {
-        std::cout << "Usage: implementFunction <function_name> <component>" << std::endl;
-        return;
+bool ParseJobCount(const std::string& text, unsigned& jobs) {
+    try {
+        size_t used = 0;
+        unsigned long value = std::stoul(text, &used);
+        if (used != text.size()) return false;
+        jobs = value == 0 ? HardwareJobCount() : static_cast<unsigned>(value);
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
     }
-    std::string functionName = args[1];
-    std::string component = args[2];
-    std::cout << "Implementing function: " << functionName << " with component: " << component << std::endl;
-    implementFunction(functionName, component);
-}
-
-void registerCommands() {
-    commandMap["help"] = CMD_help;
-    commandMap["exit"] = CMD_exit;
-    commandMap["impl"] = CMD_implementFunction;
 }
 
-// --- Simple line editor with arrow keys and history support ---
-class LineEditor {
-public:
-    LineEditor() = default;
-
-    // Returns false on EOF/terminate
-    bool readLine(const std::string& prompt, std::string& outLine) {
-#ifdef _WIN32
-        return readLineWindows(prompt, outLine);
-#else
-        return readLinePosix(prompt, outLine);
-#endif
+int CMD_implementFunction(const std::vector<std::string>& args) {
+    ImplOptions options = DefaultImplOptions();
+    std::vector<std::string> positional;
+    std::string manifestPath;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "-j" || args[i] == "-f") {
+            if (i + 1 >= args.size()) {
+                positional.clear();
+                break;
+            }
+            if (args[i] == "-f") {
+                manifestPath = args[++i];
+            } else if (!ParseJobCount(args[++i], options.jobs)) {
+                std::cerr << "Invalid job count: " << args[i] << std::endl;
+                return COMMAND_USAGE_ERROR;
+            }
+        } else if (args[i] == "-p") {
+            options.profile = true;
+        } else {
+            positional.push_back(args[i]);
+        }
     }
 
-private:
-    std::vector<std::string> history;
-    int historyIndex = -1; // -1 means no history selection
-
-#ifdef _WIN32
-    int getch_nonblocking() {
-        // blocking _getch
-        return _getch();
+    if (!manifestPath.empty() && positional.empty()) {
+        std::vector<ImplRequest> requests;
+        try {
+            requests = ReadImplManifest(manifestPath);
+        }
+        catch (const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return COMMAND_FAILED;
+        }
+        std::cout << "Implementing " << requests.size() << " function(s) from manifest: " << manifestPath << std::endl;
+        return implementFunctions(requests, options) ? COMMAND_OK : COMMAND_FAILED;
     }
-
-    bool readLineWindows(const std::string& prompt, std::string& outLine) {
-        std::string buffer;
-        size_t cursor = 0;
-        int prevDisplayLen = 0;
-
-        std::cout << prompt;
-        std::cout.flush();
-
-        while (!isProgramClosed) {
-            int c = getch_nonblocking();
-            if (c == 0 || c == 224) {
-                // special key, read next
-                int c2 = getch_nonblocking();
-                if (c2 == 72) { // up
-                    if (!history.empty()) {
-                        if (historyIndex < 0) historyIndex = (int)history.size() - 1;
-                        else historyIndex = std::max(0, historyIndex - 1);
-                        buffer = history[historyIndex];
-                        cursor = buffer.size();
-                        redraw(prompt, buffer, cursor, prevDisplayLen);
-                    }
-                } else if (c2 == 80) { // down
-                    if (!history.empty()) {
-                        if (historyIndex < 0) {
-                            // nothing
-                        } else {
-                            historyIndex = std::min((int)history.size() - 1, historyIndex + 1);
-                            if (historyIndex >= 0 && historyIndex < (int)history.size()) {
-                                buffer = history[historyIndex];
-                            } else {
-                                buffer.clear();
-                            }
-                            cursor = buffer.size();
-                            if (historyIndex >= (int)history.size()) historyIndex = -1;
-                            redraw(prompt, buffer, cursor, prevDisplayLen);
-                        }
-                    }
-                } else if (c2 == 75) { // left
-                    if (cursor > 0) {
-                        --cursor;
-                        moveCursorLeft(1);
-                    }
-                } else if (c2 == 77) { // right
-                    if (cursor < buffer.size()) {
-                        ++cursor;
-                        moveCursorRight(1);
-                    }
-                } else {
-                    // ignore others
-                }
-            } else if (c == 13) {
-                // Enter
-                std::cout << std::endl;
-                if (!buffer.empty()) {
-                    history.push_back(buffer);
-                }
-                historyIndex = -1;
-                outLine = buffer;
-                return true;
-            } else if (c == 3) {
-                // Ctrl-C
-                std::cout << "^C" << std::endl;
-                buffer.clear();
-                cursor = 0;
-                redraw(prompt, buffer, cursor, prevDisplayLen);
-                // do not exit program; just clear
-            } else if (c == 8) {
-                // Backspace
-                if (cursor > 0) {
-                    buffer.erase(cursor - 1, 1);
-                    --cursor;
-                    redraw(prompt, buffer, cursor, prevDisplayLen);
-                }
-            } else if (c == 0x1a) {
-                // Ctrl-Z maybe EOF in some consoles; treat as EOF
-                std::cout << std::endl;
-                isProgramClosed = true;
-                return false;
-            } else if (c >= 32 && c <= 126) {
-                // printable
-                buffer.insert(buffer.begin() + cursor, (char)c);
-                ++cursor;
-                redraw(prompt, buffer, cursor, prevDisplayLen);
-            } else {
-                // ignore
-            }
-        } // while
-        return false;
+    if (!manifestPath.empty() || positional.size() < 2) {
+        std::cout << "Usage: impl [-j <jobs>] [-p] <function_name> [<function_name>...] <component>" << std::endl;
+        std::cout << "       impl [-j <jobs>] [-p] -f <manifest_file>" << std::endl;
+        std::cout << "       -j 0 uses one job per hardware thread" << std::endl;
+        std::cout << "       -p adds the profiling prologue to generated functions (see 'profile')" << std::endl;
+        std::cout << "Generated code comes from templates; files in " << TEMPLATES_DIRECTORY_PATH
+            << "/[<component>/] override them" << std::endl;
+        std::cout << "(component_header.tmpl, component_source.tmpl, declaration.tmpl, definition.tmpl)." << std::endl;
+        std::cout << "With a type map in " << TYPE_HEADERS_FILE_PATH << ", new headers include only what they use." << std::endl;
+        return COMMAND_USAGE_ERROR;
     }
-
-    void moveCursorLeft(int n) {
-        while (n--) std::cout << '\b';
-        std::cout.flush();
+    std::string component = positional.back();
+    if (positional.size() == 2) {
+        std::string functionName = positional[0];
+        std::cout << "Implementing function: " << functionName << " with component: " << component << std::endl;
+        return implementFunction(functionName, component, options) ? COMMAND_OK : COMMAND_FAILED;
     }
-    void moveCursorRight(int n) {
-        // print the character under cursor by reprinting remainder then moving back
-        // simpler: output the characters to move right one-by-one if possible
-        // But safe approach: just redraw line (handled by caller normally). For small moves we can:
-        // This implementation will just re-render full line when needed; here do nothing.
-        (void)n;
+    std::vector<ImplRequest> requests;
+    for (size_t i = 0; i + 1 < positional.size(); ++i) {
+        requests.push_back({ positional[i], component });
     }
+    std::cout << "Implementing " << requests.size() << " functions with component: " << component << std::endl;
+    return implementFunctions(requests, options) ? COMMAND_OK : COMMAND_FAILED;
+}
 
-    void redraw(const std::string& prompt, const std::string& buffer, size_t cursor, int &prevDisplayLen) {
-        // carriage return, print prompt + buffer, pad with spaces to clear leftover, then reposition cursor
-        std::cout << '\r' << prompt << buffer;
-        int curDisplayLen = (int)(prompt.size() + buffer.size());
-        if (prevDisplayLen > curDisplayLen) {
-            // clear leftover
-            for (int i = 0; i < prevDisplayLen - curDisplayLen; ++i) std::cout << ' ';
-            // move back again
-            std::cout << '\r' << prompt << buffer;
-        }
-        prevDisplayLen = curDisplayLen;
-        // move cursor to the logical position
-        // move back from end to cursor position
-        int moveBack = (int)(buffer.size() - cursor);
-        for (int i = 0; i < moveBack; ++i) std::cout << '\b';
-        std::cout.flush();
+int CMD_stats(const std::vector<std::string>& args) {
+    if (args.size() == 1) {
+        PrintStats(std::cout);
+        return COMMAND_OK;
     }
-
-#else // POSIX
-
-    struct TermState {
-        termios orig;
-        bool valid = false;
-    };
-
-    bool enableRawMode(TermState &st) {
-        if (!isatty(STDIN_FILENO)) return false;
-        if (tcgetattr(STDIN_FILENO, &st.orig) == -1) return false;
-        termios raw = st.orig;
-        raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
-        raw.c_iflag &= ~(IXON | ICRNL | BRKINT | INPCK | ISTRIP);
-        raw.c_oflag &= ~(OPOST);
-        raw.c_cc[VMIN] = 1;
-        raw.c_cc[VTIME] = 0;
-        if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) return false;
-        st.valid = true;
-        return true;
+    if (args.size() == 2 && args[1] == "on") {
+        SetStatsEnabled(true);
+        std::cout << "Statistics enabled" << std::endl;
+        return COMMAND_OK;
     }
+    if (args.size() == 2 && args[1] == "off") {
+        SetStatsEnabled(false);
+        std::cout << "Statistics disabled" << std::endl;
+        return COMMAND_OK;
+    }
+    if (args.size() == 2 && args[1] == "reset") {
+        ResetStats();
+        std::cout << "Statistics cleared" << std::endl;
+        return COMMAND_OK;
+    }
+    std::cout << "Usage: stats [on|off|reset]" << std::endl;
+    return COMMAND_USAGE_ERROR;
+}
 
-    void disableRawMode(TermState &st) {
-        if (st.valid) {
-            tcsetattr(STDIN_FILENO, TCSAFLUSH, &st.orig);
-            st.valid = false;
+int CMD_watch(const std::vector<std::string>& args) {
+    if (args.size() == 1) {
+        std::cout << "File watcher: " << FileWatcherMode() << std::endl;
+        return COMMAND_OK;
+    }
+    if (args.size() == 2 && args[1] == "on") {
+        if (!StartWorkspaceWatcher()) {
+            std::cerr << "Cannot watch '" << GL_IMPL_DIRECTORY_PATH << "'" << std::endl;
+            return COMMAND_FAILED;
         }
+        std::cout << "File watcher: " << FileWatcherMode() << std::endl;
+        return COMMAND_OK;
+    }
+    if (args.size() == 2 && args[1] == "off") {
+        StopFileWatcher();
+        std::cout << "File watcher: off" << std::endl;
+        return COMMAND_OK;
     }
+    std::cout << "Usage: watch [on|off]" << std::endl;
+    return COMMAND_USAGE_ERROR;
+}
+
+void registerCommands() {
+    commandMap["help"] = CMD_help;
+    commandMap["exit"] = CMD_exit;
+    commandMap["impl"] = CMD_implementFunction;
+    commandMap["stats"] = CMD_stats;
+    commandMap["watch"] = CMD_watch;
+    commandMap["coverage"] = CMD_coverage;
+    commandMap["dispatch"] = CMD_dispatch;
+    commandMap["profile"] = CMD_profile;
+    commandMap["includes"] = CMD_includes;
+    commandMap["pch"] = CMD_pch;
+    commandMap["unity"] = CMD_unity;
+    commandMap["verify"] = CMD_verify;
+    commandMap["serve"] = CMD_serve;
+    commandMap["stage"] = CMD_stage;
+    commandMap["diff"] = CMD_diff;
+    commandMap["commit"] = CMD_commit;
+    commandMap["discard"] = CMD_discard;
+    commandMap["jobs"] = CMD_jobs;
+}
 
-    int readByte() {
-        unsigned char c;
-        ssize_t n = read(STDIN_FILENO, &c, 1);
-        if (n <= 0) return -1;
-        return c;
+int RunCommand(const std::vector<std::string>& tokens) {
+    auto it = commandMap.find(tokens[0]);
+    if (it == commandMap.end()) {
+        std::cout << "Unknown command: " << tokens[0] << std::endl;
+        return COMMAND_USAGE_ERROR;
     }
 
-    bool readLinePosix(const std::string& prompt, std::string& outLine) {
-        TermState st;
-        bool rawOk = enableRawMode(st);
-        std::string buffer;
-        size_t cursor = 0;
-        int prevDisplayLen = 0;
-
-        std::cout << prompt;
-        std::cout.flush();
-
-        while (!isProgramClosed) {
-            int c = readByte();
-            if (c == -1) {
-                disableRawMode(st);
-                isProgramClosed = true;
-                return false;
-            }
-            if (c == '\r' || c == '\n') {
-                std::cout << "\r\n";
-                if (!buffer.empty()) history.push_back(buffer);
-                historyIndex = -1;
-                outLine = buffer;
-                disableRawMode(st);
-                return true;
-            } else if (c == 127 || c == 8) { // backspace (127 on many terminals)
-                if (cursor > 0) {
-                    buffer.erase(cursor - 1, 1);
-                    --cursor;
-                    redraw(prompt, buffer, cursor, prevDisplayLen);
-                }
-            } else if (c == 3) { // Ctrl-C
-                std::cout << "^C" << std::endl;
-                buffer.clear();
-                cursor = 0;
-                redraw(prompt, buffer, cursor, prevDisplayLen);
-            } else if (c == 4) { // Ctrl-D -> treat as EOF
-                std::cout << std::endl;
-                disableRawMode(st);
-                isProgramClosed = true;
-                return false;
-            } else if (c == 27) {
-                // Escape sequence: read two more (maybe more)
-                int c1 = readByte();
-                if (c1 == -1) { disableRawMode(st); return false; }
-                if (c1 == '[') {
-                    int c2 = readByte();
-                    if (c2 == -1) { disableRawMode(st); return false; }
-                    if (c2 == 'A') { // up
-                        if (!history.empty()) {
-                            if (historyIndex < 0) historyIndex = (int)history.size() - 1;
-                            else historyIndex = std::max(0, historyIndex - 1);
-                            buffer = history[historyIndex];
-                            cursor = buffer.size();
-                            redraw(prompt, buffer, cursor, prevDisplayLen);
-                        }
-                    } else if (c2 == 'B') { // down
-                        if (history.empty()) return false;
-
-                        if (historyIndex >= 0) {
-                            historyIndex++;
-                            if (historyIndex >= (int)history.size()) {
-                                historyIndex = -1;
-                                buffer.clear();
-                            } else {
-                                buffer = history[historyIndex];
-                            }
-                            cursor = buffer.size();
-                            redraw(prompt, buffer, cursor, prevDisplayLen);
-                        }
-                    } else if (c2 == 'C') { // right
-                        if (cursor < buffer.size()) {
-                            ++cursor;
-                            redraw(prompt, buffer, cursor, prevDisplayLen);
-                        }
-                    } else if (c2 == 'D') { // left
-                        if (cursor > 0) {
-                            --cursor;
-                            redraw(prompt, buffer, cursor, prevDisplayLen);
-                        }
-                    } else {
-                        // other CSI sequences ignored
-                    }
-                } else {
-                    // other escapes ignored
-                }
-            } else if (c >= 32 && c <= 126) {
-                buffer.insert(buffer.begin() + cursor, (char)c);
-                ++cursor;
-                redraw(prompt, buffer, cursor, prevDisplayLen);
-            } else {
-                // ignore other controls
-            }
-        } // while
+    std::string phase;
+    if (IsInstrumentationActive()) phase = "command:" + tokens[0];
+    ScopedTimer timer(phase);
+    return it->second(tokens);
+}
 
-        disableRawMode(st);
-        return false;
+// Ctrl-C while no line editor reads keys: the first asks the running command to
+// stop at its next safe point, a second one ends the program as usual.
+static void HandleInterrupt(int) {
+    if (IsCancellationRequested()) {
+        std::signal(SIGINT, SIG_DFL);
+        std::raise(SIGINT);
+        return;
     }
+    RequestCancellation();
+}
 
-    void redraw(const std::string& prompt, const std::string& buffer, size_t cursor, int &prevDisplayLen) {
-        // Move to start of line, print prompt+buffer, clear leftover, then move cursor to position
-        std::cout << '\r' << prompt << buffer;
-        int curDisplayLen = (int)(prompt.size() + buffer.size());
-        if (prevDisplayLen > curDisplayLen) {
-            for (int i = 0; i < prevDisplayLen - curDisplayLen; ++i) std::cout << ' ';
-            std::cout << '\r' << prompt << buffer;
-        }
-        prevDisplayLen = curDisplayLen;
-        // move back from end to cursor position
-        int moveBack = (int)(buffer.size() - cursor);
-        for (int i = 0; i < moveBack; ++i) std::cout << '\b';
-        std::cout.flush();
+#ifdef _WIN32
+
+void MainLoop() {
+    LineEditor editor;
+    std::string input;
+    const std::string prompt = ">>> ";
+    while (!isProgramClosed) {
+        bool ok = editor.readLine(prompt, input);
+        if (!ok) break; // EOF or program closed
+        auto tokens = split(input);
+        if (tokens.empty()) continue;
+
+        BeginCommandProgress();
+        RunCommand(tokens);
     }
-#endif
-};
+}
+
+#else
 
-// --- End LineEditor ---
+// Commands that only look at the queue, which run on the input thread at once.
+static bool RunsImmediately(const std::string& command) {
+    return command == "jobs" || command == "help";
+}
+
+// serve redirects the process-wide std::cout and std::cerr to its clients, which
+// the prompt keeps writing to, so it only runs as 'MobileGLCodeManager serve'.
+static bool RunsOnlyOutsidePrompt(const std::string& command) {
+    return command == "serve";
+}
 
+// Commands run on the queue's worker while the prompt keeps reading lines; their
+// output is printed above the prompt. 'exit' and EOF wait for queued commands.
 void MainLoop() {
     LineEditor editor;
     std::string input;
     const std::string prompt = ">>> ";
+
+    CommandQueue queue;
+    editor.onInterrupt = [&queue] { return queue.CancelRunning(); };
+    PromptOutput output(editor);
+    std::streambuf* coutBuffer = std::cout.rdbuf(&output);
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(&output);
+    SetActiveCommandQueue(&queue);
+
+    std::vector<std::string> exitTokens;
     while (!isProgramClosed) {
         bool ok = editor.readLine(prompt, input);
         if (!ok) break; // EOF or program closed
         auto tokens = split(input);
         if (tokens.empty()) continue;
 
-        auto cmd = tokens[0];
-        auto it = commandMap.find(cmd);
-        if (it != commandMap.end()) {
-            it->second(tokens);
-        } else {
-            std::cout << "Unknown command: " << cmd << std::endl;
+        if (tokens[0] == "exit") {
+            exitTokens = std::move(tokens);
+            break;
+        }
+        if (RunsImmediately(tokens[0])) {
+            RunCommand(tokens);
+            continue;
+        }
+        if (RunsOnlyOutsidePrompt(tokens[0])) {
+            std::cerr << "'" << tokens[0] << "' cannot run at the prompt; start it as 'MobileGLCodeManager " << tokens[0]
+                << " ...' instead" << std::endl;
+            continue;
+        }
+        bool busy = queue.Pending() > 0;
+        size_t id = queue.Submit(std::move(tokens));
+        if (busy) std::cout << "[" << id << "] queued" << std::endl;
+    }
+
+    if (size_t pending = queue.Pending()) {
+        std::cout << "Waiting for " << pending << " command(s); Ctrl-C cancels the running one" << std::endl;
+    }
+    queue.Wait();
+    SetActiveCommandQueue(nullptr);
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+    if (!exitTokens.empty()) RunCommand(exitTokens);
+}
+
+#endif
+
+// Runs one command per line without any terminal setup. Blank lines and lines
+// starting with '#' are skipped. Stops at the first failing command unless
+// keepGoing is set; returns the status of the last failure, or COMMAND_OK.
+int RunScript(std::istream& input, bool keepGoing) {
+    int result = COMMAND_OK;
+    std::string line;
+    while (!isProgramClosed && std::getline(input, line)) {
+        auto tokens = split(line);
+        if (tokens.empty() || tokens[0][0] == '#') continue;
+
+        BeginCommandProgress();
+        int status = RunCommand(tokens);
+        if (status != COMMAND_OK) {
+            result = status;
+            if (!keepGoing) break;
         }
     }
+    return result;
+}
+
+bool IsInteractiveInput() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(STDIN_FILENO) != 0;
+#endif
 }
 
-int main() {
+void PrintUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options] [<command> [args...]]" << std::endl;
+    std::cout << "  <command> [args...]   run a single command and exit with its status" << std::endl;
+    std::cout << "  --script <file>       run commands from a file ('-' for stdin)" << std::endl;
+    std::cout << "  --jobs <n>            worker threads for impl (0 = one per hardware thread)" << std::endl;
+    std::cout << "  --stats               record timings and I/O, print them on exit" << std::endl;
+    std::cout << "  --trace <file>        write a Chrome trace-event JSON file on exit" << std::endl;
+    std::cout << "  --keep-going          in script mode, continue after a failing command" << std::endl;
+    std::cout << "  --help                show this message" << std::endl;
+    std::cout << "Without a command, commands are read from stdin when it is not a terminal;" << std::endl;
+    std::cout << "otherwise the interactive prompt is started. Its history is kept in" << std::endl;
+    std::cout << "$MGCM_HISTORY_FILE (default ~/.mgcm_history, empty to disable), capped at" << std::endl;
+    std::cout << "$MGCM_HISTORY_SIZE entries (default 10000); Ctrl-R searches it." << std::endl;
+    std::cout << "At the prompt, commands run in the background and lines entered meanwhile are" << std::endl;
+    std::cout << "queued ('jobs' lists them). Ctrl-C cancels the running command at a safe point;" << std::endl;
+    std::cout << "outside the prompt a second Ctrl-C ends the program." << std::endl;
+}
+
+int RunMode(const std::vector<std::string>& commandArgs, const std::string& scriptPath, bool keepGoing) {
+    if (!commandArgs.empty()) {
+        BeginCommandProgress();
+        return RunCommand(commandArgs);
+    }
+
+    if (scriptPath == "-" || (scriptPath.empty() && !IsInteractiveInput())) {
+        return RunScript(std::cin, keepGoing);
+    }
+
+    if (!scriptPath.empty()) {
+        std::ifstream scriptFile(scriptPath);
+        if (!scriptFile.is_open()) {
+            std::cerr << "Cannot open script: " << scriptPath << std::endl;
+            return COMMAND_FAILED;
+        }
+        return RunScript(scriptFile, keepGoing);
+    }
+
     std::cout << "MobileGL Code Manager" << std::endl;
-    registerCommands();
+    // Keeps cached state current while the prompt waits for input.
+    StartWorkspaceWatcher();
     MainLoop();
-    return 0;
+    StopFileWatcher();
+    return COMMAND_OK;
+}
+
+int main(int argc, char** argv) {
+    std::string scriptPath;
+    bool keepGoing = false;
+    bool printStatsOnExit = false;
+    std::vector<std::string> commandArgs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (!commandArgs.empty()) {
+            commandArgs.push_back(arg);
+        } else if (arg == "--script") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return COMMAND_USAGE_ERROR;
+            }
+            scriptPath = argv[++i];
+        } else if (arg == "--jobs") {
+            if (i + 1 >= argc || !ParseJobCount(argv[++i], DefaultImplOptions().jobs)) {
+                PrintUsage(argv[0]);
+                return COMMAND_USAGE_ERROR;
+            }
+        } else if (arg == "--stats") {
+            printStatsOnExit = true;
+            SetStatsEnabled(true);
+        } else if (arg == "--trace") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return COMMAND_USAGE_ERROR;
+            }
+            StartTrace(argv[++i]);
+        } else if (arg == "--keep-going") {
+            keepGoing = true;
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return COMMAND_OK;
+        } else if (arg.starts_with("--")) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return COMMAND_USAGE_ERROR;
+        } else {
+            commandArgs.push_back(arg);
+        }
+    }
+
+    registerCommands();
+    std::signal(SIGINT, HandleInterrupt);
+
+    int status = RunMode(commandArgs, scriptPath, keepGoing);
+
+    // Never lose staged edits: leaving the program commits them.
+    if (HasStagedFiles()) {
+        int commitStatus = CMD_commit({ "commit" });
+        if (status == COMMAND_OK) status = commitStatus;
+    }
+    SaveWorkspaceCache();
+
+    if (printStatsOnExit) PrintStats(std::cerr);
+    FinishTrace();
+    return status;
 }